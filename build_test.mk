@@ -49,6 +49,8 @@ endif
 include common_features.mk
 include $(TMK_PATH)/common.mk
 include $(QUANTUM_PATH)/serial_link/tests/rules.mk
+include $(TMK_PATH)/common/tests/rules.mk
+include $(QUANTUM_PATH)/debounce/tests/rules.mk
 ifneq ($(filter $(FULL_TESTS),$(TEST)),)
 include build_full_test.mk
 endif
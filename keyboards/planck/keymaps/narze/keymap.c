@@ -271,6 +271,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         persistant_default_layer_set(1UL<<_QWERTY);
 
         key_combos[CB_SUPERDUPER].keys = superduper_combos[_QWERTY];
+        combo_init();
         eeprom_update_byte(EECONFIG_SUPERDUPER_INDEX, _QWERTY);
       }
       return false;
@@ -283,6 +284,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         persistant_default_layer_set(1UL<<_COLEMAK);
 
         key_combos[CB_SUPERDUPER].keys = superduper_combos[_COLEMAK];
+        combo_init();
         eeprom_update_byte(EECONFIG_SUPERDUPER_INDEX, _COLEMAK);
       }
       return false;
@@ -295,6 +297,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         persistant_default_layer_set(1UL<<_QWOC);
 
         key_combos[CB_SUPERDUPER].keys = superduper_combos[_QWOC];
+        combo_init();
         eeprom_update_byte(EECONFIG_SUPERDUPER_INDEX, _QWOC);
       }
       return false;
@@ -400,12 +403,14 @@ void set_superduper_key_combos(void) {
     case _COLEMAK:
     case _QWOC:
       key_combos[CB_SUPERDUPER].keys = superduper_combos[layer];
+      combo_init();
       break;
   }
 }
 
 void clear_superduper_key_combos(void) {
   key_combos[CB_SUPERDUPER].keys = empty_combo;
+  combo_init();
 }
 
 void matrix_scan_user(void) {
@@ -440,7 +445,7 @@ void music_scale_user(void)
 
 // Combos
 
-void process_combo_event(uint8_t combo_index, bool pressed) {
+void process_combo_event(uint16_t combo_index, bool pressed) {
   if (pressed) {
     switch(combo_index) {
       case CB_SUPERDUPER:
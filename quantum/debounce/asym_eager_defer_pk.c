@@ -0,0 +1,112 @@
+/*
+Copyright 2017 Alex Ong<the.onga@gmail.com>
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Asymmetric per-key algorithm: eager key-down, deferred key-up. Uses a 4 or
+8-bit counter and a bit per key.
+A key-down is pushed immediately, after which the key ignores its input for
+DEBOUNCE milliseconds like eager_pk. A key-up is only pushed once the key has
+stayed up for DEBOUNCE milliseconds, a key that bounces back down before then
+stays pressed. Presses get through without delay, and chatter while a key is
+held can't cause a spurious release and second press.
+*/
+
+#include "debounce_counters.h"
+
+// Keys whose counter times a release rather than the lockout after a press
+static matrix_row_t debounce_releasing[MATRIX_ROWS];
+
+void debounce_init(uint8_t num_rows)
+{
+  debounce_counters_init(num_rows);
+  memset(debounce_releasing, 0, sizeof(debounce_releasing));
+}
+
+// Ends the lockout after a press, or pushes the release, once DEBOUNCE ms have passed
+static inline void debounce_key_expire(debounce_counter_t *counter, matrix_row_t col_mask, matrix_row_t *existing_row, matrix_row_t *releasing, uint8_t current_time)
+{
+  if (debounce_counter_expired(*counter, current_time))
+  {
+    *counter = DEBOUNCE_ELAPSED;
+    if (*releasing & col_mask)
+    {
+      *existing_row &= ~col_mask;
+      *releasing &= ~col_mask;
+    }
+  }
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
+{
+  uint8_t current_time;
+  if (!debounce_scan_needed(changed, &current_time))
+  {
+    return;
+  }
+  uint8_t oldest_age = 0;
+  for (uint8_t row = 0; row < num_rows; row++)
+  {
+    if (!debounce_row_needed(raw[row], cooked[row], row))
+    {
+      continue;
+    }
+    uint16_t index = row * MATRIX_COLS;
+    matrix_row_t existing_row = cooked[row];
+    matrix_row_t raw_row = raw[row];
+    matrix_row_t releasing = debounce_releasing[row];
+    bool live = false;
+
+    for (uint8_t col = 0; col < MATRIX_COLS; col++)
+    {
+      matrix_row_t col_mask = (ROW_SHIFTER << col);
+      debounce_counter_t counter = debounce_counter_get(index);
+      if ((releasing & col_mask) && (raw_row & col_mask))
+      {
+        // pressed again before the release was pushed
+        counter = DEBOUNCE_ELAPSED;
+        releasing &= ~col_mask;
+      }
+      debounce_key_expire(&counter, col_mask, &existing_row, &releasing, current_time);
+      if (counter == DEBOUNCE_ELAPSED && ((existing_row ^ raw_row) & col_mask))
+      {
+        counter = current_time;
+        if (raw_row & col_mask)
+        {
+          existing_row |= col_mask;
+        }
+        else
+        {
+          releasing |= col_mask;
+          // checked right away too, so DEBOUNCE 0 doesn't cost a scan
+          debounce_key_expire(&counter, col_mask, &existing_row, &releasing, current_time);
+        }
+      }
+      if (counter != DEBOUNCE_ELAPSED)
+      {
+        live = true;
+        debounce_counter_running(counter, current_time, &oldest_age);
+      }
+      debounce_counter_set(index++, counter);
+    }
+    cooked[row] = existing_row;
+    debounce_releasing[row] = releasing;
+    debounce_row_set_live(row, live);
+  }
+  debounce_scan_done(current_time, oldest_age);
+}
+
+bool debounce_active(void)
+{
+  return true;
+}
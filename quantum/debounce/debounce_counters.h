@@ -0,0 +1,209 @@
+/*
+Copyright 2017 Alex Ong<the.onga@gmail.com>
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Per-key timestamps shared by the per-key debounce algorithms.
+Every key has a counter that holds the time its debounce period started,
+modulo MAX_DEBOUNCE, or DEBOUNCE_ELAPSED when it isn't debouncing. The
+counters are 4 bits wide and packed two to a byte when DEBOUNCE is short
+enough, 8 bits wide otherwise.
+A gap between scans long enough for a timestamp to wrap around rebases the
+running counters to the current time first, so a slow scan loop can only
+delay a change, never lose it.
+The rows that have running counters are tracked, together with the start of
+the oldest one. A scan without raw changes only walks the matrix when that
+counter expires, and then only the rows that changed or have counters.
+All state is sized at compile time, MATRIX_ROWS covers both halves of a
+split keyboard.
+Only include this from the debounce algorithm that is compiled in.
+*/
+
+#pragma once
+
+#include "config.h"
+#include "matrix.h"
+#include "timer.h"
+#include <string.h>
+
+#ifndef DEBOUNCE
+  #define DEBOUNCE 5
+#endif
+
+
+#if (MATRIX_COLS <= 8)
+#    define ROW_SHIFTER ((uint8_t)1)
+#elif (MATRIX_COLS <= 16)
+#    define ROW_SHIFTER ((uint16_t)1)
+#elif (MATRIX_COLS <= 32)
+#    define ROW_SHIFTER  ((uint32_t)1)
+#endif
+
+#define DEBOUNCE_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+#define debounce_counter_t uint8_t
+
+// A counter has to tell apart ages up to DEBOUNCE, 15 timestamps and
+// DEBOUNCE_ELAPSED fit into 4 bits. Only a DEBOUNCE below half of that range
+// is packed, so the counters are rarely rebased, see debounce_scan_needed().
+#if DEBOUNCE < 8
+#  define DEBOUNCE_ELAPSED 15
+#  define MAX_DEBOUNCE 15
+
+static uint8_t debounce_counters[(DEBOUNCE_KEYS + 1) / 2];
+
+static inline debounce_counter_t debounce_counter_get(uint16_t index)
+{
+  uint8_t counters = debounce_counters[index / 2];
+  return index % 2 ? counters >> 4 : counters & 0x0F;
+}
+
+static inline void debounce_counter_set(uint16_t index, debounce_counter_t value)
+{
+  uint8_t *counters = &debounce_counters[index / 2];
+  *counters = index % 2 ? (*counters & 0x0F) | (value << 4) : (*counters & 0xF0) | value;
+}
+#else
+#  define DEBOUNCE_ELAPSED 251
+#  define MAX_DEBOUNCE (DEBOUNCE_ELAPSED - 1)
+#  if DEBOUNCE >= MAX_DEBOUNCE
+#    error "DEBOUNCE must be below 250 ms for the per-key debounce algorithms"
+#  endif
+
+static debounce_counter_t debounce_counters[DEBOUNCE_KEYS];
+
+static inline debounce_counter_t debounce_counter_get(uint16_t index)
+{
+  return debounce_counters[index];
+}
+
+static inline void debounce_counter_set(uint16_t index, debounce_counter_t value)
+{
+  debounce_counters[index] = value;
+}
+#endif
+
+// Bit per row, set while the row has running counters
+static uint8_t debounce_live_rows[(MATRIX_ROWS + 7) / 8];
+static uint8_t debounce_live_row_count = 0;
+// Start of the oldest running counter, which is the next one to expire
+static uint8_t debounce_oldest_start;
+// The time the counters were last checked, all running ones were younger than DEBOUNCE then
+static uint16_t debounce_last_scan;
+
+//we use num_rows rather than MATRIX_ROWS to support split keyboards
+static void debounce_counters_init(uint8_t num_rows)
+{
+  for (uint16_t i = 0; i < num_rows * MATRIX_COLS; i++)
+  {
+    debounce_counter_set(i, DEBOUNCE_ELAPSED);
+  }
+  memset(debounce_live_rows, 0, sizeof(debounce_live_rows));
+  debounce_live_row_count = 0;
+}
+
+// Whether DEBOUNCE milliseconds have passed since the counter was started
+static inline bool debounce_counter_expired(debounce_counter_t counter, uint8_t current_time)
+{
+  return counter != DEBOUNCE_ELAPSED && TIMER_DIFF(current_time, counter, MAX_DEBOUNCE) >= DEBOUNCE;
+}
+
+static inline bool debounce_row_is_live(uint8_t row)
+{
+  return debounce_live_rows[row / 8] & (1 << (row % 8));
+}
+
+static inline void debounce_row_set_live(uint8_t row, bool live)
+{
+  if (live != debounce_row_is_live(row))
+  {
+    debounce_live_rows[row / 8] ^= 1 << (row % 8);
+    debounce_live_row_count += live ? 1 : -1;
+  }
+}
+
+// The start of a counter that was running at the last scan, moved to the
+// current time with its age capped at DEBOUNCE
+static inline debounce_counter_t debounce_counter_rebased(debounce_counter_t counter, uint8_t current_time, uint16_t gap)
+{
+  uint16_t age = TIMER_DIFF(debounce_last_scan % MAX_DEBOUNCE, counter, MAX_DEBOUNCE) + gap;
+  if (age > DEBOUNCE)
+  {
+    age = DEBOUNCE;
+  }
+  return TIMER_DIFF(current_time, age, MAX_DEBOUNCE);
+}
+
+// Rebases every running counter after a gap of `gap` ms since the last scan,
+// their timestamps could have wrapped around otherwise
+static void debounce_counters_rebase(uint8_t current_time, uint16_t gap)
+{
+  for (uint8_t row = 0; row < MATRIX_ROWS; row++)
+  {
+    if (!debounce_row_is_live(row))
+    {
+      continue;
+    }
+    for (uint16_t index = row * MATRIX_COLS; index < (row + 1) * MATRIX_COLS; index++)
+    {
+      debounce_counter_t counter = debounce_counter_get(index);
+      if (counter != DEBOUNCE_ELAPSED)
+      {
+        debounce_counter_set(index, debounce_counter_rebased(counter, current_time, gap));
+      }
+    }
+  }
+  debounce_oldest_start = debounce_counter_rebased(debounce_oldest_start, current_time, gap);
+}
+
+// Whether the rows have to be walked, because the raw matrix changed or the oldest counter expired.
+// Sets current_time when they do, the timer isn't even read on an idle scan.
+static inline bool debounce_scan_needed(bool changed, uint8_t *current_time)
+{
+  if (!changed && debounce_live_row_count == 0)
+  {
+    return false;
+  }
+  uint16_t now = timer_read();
+  *current_time = now % MAX_DEBOUNCE;
+  // A running counter is younger than DEBOUNCE at a scan, its age only
+  // reaches MAX_DEBOUNCE after a gap of at least MAX_DEBOUNCE - DEBOUNCE
+  uint16_t gap = TIMER_DIFF_16(now, debounce_last_scan);
+  if (debounce_live_row_count > 0 && gap >= MAX_DEBOUNCE - DEBOUNCE)
+  {
+    debounce_counters_rebase(*current_time, gap);
+  }
+  debounce_last_scan = now;
+  return changed || TIMER_DIFF(*current_time, debounce_oldest_start, MAX_DEBOUNCE) >= DEBOUNCE;
+}
+
+// Whether a row has to be walked in a scan that walks the rows
+static inline bool debounce_row_needed(matrix_row_t raw_row, matrix_row_t cooked_row, uint8_t row)
+{
+  return raw_row != cooked_row || debounce_row_is_live(row);
+}
+
+// Notes a counter that is still running after the scan, the age of the oldest one is kept in oldest_age
+static inline void debounce_counter_running(debounce_counter_t counter, uint8_t current_time, uint8_t *oldest_age)
+{
+  uint8_t age = TIMER_DIFF(current_time, counter, MAX_DEBOUNCE);
+  if (age > *oldest_age)
+  {
+    *oldest_age = age;
+  }
+}
+
+static inline void debounce_scan_done(uint8_t current_time, uint8_t oldest_age)
+{
+  debounce_oldest_start = TIMER_DIFF(current_time, oldest_age, MAX_DEBOUNCE);
+}
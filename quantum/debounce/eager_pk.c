@@ -13,105 +13,72 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 /*
-Basic per-key algorithm. Uses an 8-bit counter per key.
+Basic per-key algorithm. Uses a 4 or 8-bit counter per key.
 After pressing a key, it immediately changes state, and sets a counter.
 No further inputs are accepted until DEBOUNCE milliseconds have occurred.
 */
 
-#include "matrix.h"
-#include "timer.h"
-#include "quantum.h"
-#include <stdlib.h>
+#include "debounce_counters.h"
 
-#ifndef DEBOUNCE
-  #define DEBOUNCE 5
-#endif
+static bool debounce_row(matrix_row_t raw_row, matrix_row_t *cooked_row, uint16_t index, uint8_t current_time, uint8_t *oldest_age);
 
-
-#if (MATRIX_COLS <= 8)
-#    define ROW_SHIFTER ((uint8_t)1)
-#elif (MATRIX_COLS <= 16)
-#    define ROW_SHIFTER ((uint16_t)1)
-#elif (MATRIX_COLS <= 32)
-#    define ROW_SHIFTER  ((uint32_t)1)
-#endif
-
-
-
-#define debounce_counter_t uint8_t
-
-static debounce_counter_t *debounce_counters;
-
-#define DEBOUNCE_ELAPSED 251
-#define MAX_DEBOUNCE (DEBOUNCE_ELAPSED - 1)
-
-void update_debounce_counters(uint8_t num_rows, uint8_t current_time);
-void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t current_time);
-
-//we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows)
 {
-  debounce_counters = (debounce_counter_t*)malloc(num_rows*MATRIX_COLS * sizeof(debounce_counter_t));
-  int i = 0;
-  for (uint8_t r = 0; r < num_rows; r++)
-  {
-    for (uint8_t c = 0; c < MATRIX_COLS; c++)
-    {
-      debounce_counters[i++] = DEBOUNCE_ELAPSED;
-    }
-  }
+  debounce_counters_init(num_rows);
 }
 
 void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
 {
-  uint8_t current_time = timer_read() % MAX_DEBOUNCE;
-  update_debounce_counters(num_rows, current_time);
-  transfer_matrix_values(raw, cooked, num_rows, current_time);
-}
-
-//If the current time is > debounce counter, set the counter to enable input.
-void update_debounce_counters(uint8_t num_rows, uint8_t current_time)
-{
-  debounce_counter_t *debounce_pointer = debounce_counters;
+  uint8_t current_time;
+  if (!debounce_scan_needed(changed, &current_time))
+  {
+    return;
+  }
+  uint8_t oldest_age = 0;
   for (uint8_t row = 0; row < num_rows; row++)
   {
-    for (uint8_t col = 0; col < MATRIX_COLS; col++)
+    if (debounce_row_needed(raw[row], cooked[row], row))
     {
-      if (*debounce_pointer != DEBOUNCE_ELAPSED)
-      {
-        if (TIMER_DIFF(current_time, *debounce_pointer, MAX_DEBOUNCE) >= DEBOUNCE) {
-          *debounce_pointer = DEBOUNCE_ELAPSED;
-        }
-      }
-      debounce_pointer++;
+      bool live = debounce_row(raw[row], &cooked[row], row * MATRIX_COLS, current_time, &oldest_age);
+      debounce_row_set_live(row, live);
     }
   }
+  debounce_scan_done(current_time, oldest_age);
 }
 
-// upload from raw_matrix to final matrix;
-void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t current_time)
+// Expires the counters of the row and uploads its changes from the raw matrix to the final one.
+// Returns whether any counter of the row is still running.
+static bool debounce_row(matrix_row_t raw_row, matrix_row_t *cooked_row, uint16_t index, uint8_t current_time, uint8_t *oldest_age)
 {
-  debounce_counter_t *debounce_pointer = debounce_counters;
-  for (uint8_t row = 0; row < num_rows; row++)
-  {
-    matrix_row_t existing_row = cooked[row]; 
-    matrix_row_t raw_row = raw[row];
+  matrix_row_t existing_row = *cooked_row;
+  bool live = false;
 
-    for (uint8_t col = 0; col < MATRIX_COLS; col++)
+  for (uint8_t col = 0; col < MATRIX_COLS; col++)
+  {
+    matrix_row_t col_mask = (ROW_SHIFTER << col);
+    debounce_counter_t counter = debounce_counter_get(index);
+    //If the current time is > debounce counter, set the counter to enable input.
+    if (debounce_counter_expired(counter, current_time))
+    {
+      counter = DEBOUNCE_ELAPSED;
+      debounce_counter_set(index, counter);
+    }
+    if (counter == DEBOUNCE_ELAPSED &&
+        ((existing_row ^ raw_row) & col_mask))
     {
-      matrix_row_t col_mask = (ROW_SHIFTER << col);
-      bool final_value = raw_row & col_mask;
-      bool existing_value = existing_row & col_mask;
-      if (*debounce_pointer == DEBOUNCE_ELAPSED &&
-          (existing_value != final_value))
-      {
-        *debounce_pointer = current_time;
-        existing_row ^= col_mask; //flip the bit.
-      }
-      debounce_pointer++;
+      counter = current_time;
+      debounce_counter_set(index, counter);
+      existing_row ^= col_mask; //flip the bit.
     }
-    cooked[row] = existing_row;
-  }  
+    if (counter != DEBOUNCE_ELAPSED)
+    {
+      live = true;
+      debounce_counter_running(counter, current_time, oldest_age);
+    }
+    index++;
+  }
+  *cooked_row = existing_row;
+  return live;
 }
 
 bool debounce_active(void)
@@ -21,7 +21,6 @@ No further inputs are accepted until DEBOUNCE milliseconds have occurred.
 #include "matrix.h"
 #include "timer.h"
 #include "quantum.h"
-#include <stdlib.h>
 
 #ifndef DEBOUNCE
   #define DEBOUNCE 5
@@ -30,7 +29,7 @@ No further inputs are accepted until DEBOUNCE milliseconds have occurred.
 
 #define debounce_counter_t uint8_t
 
-static debounce_counter_t *debounce_counters;
+static debounce_counter_t debounce_counters[MATRIX_ROWS];
 
 #define DEBOUNCE_ELAPSED 251
 #define MAX_DEBOUNCE (DEBOUNCE_ELAPSED - 1)
@@ -41,7 +40,6 @@ void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t n
 //we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows)
 {
-  debounce_counters = (debounce_counter_t*)malloc(num_rows*sizeof(debounce_counter_t));  
   for (uint8_t r = 0; r < num_rows; r++)
   {    
     debounce_counters[r] = DEBOUNCE_ELAPSED;
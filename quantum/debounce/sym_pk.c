@@ -0,0 +1,87 @@
+/*
+Copyright 2017 Alex Ong<the.onga@gmail.com>
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Basic symmetric per-key algorithm. Uses a 4 or 8-bit counter per key.
+When a key changes state a counter is started, the change is pushed once the
+key has kept its new state for DEBOUNCE milliseconds. A key that bounces back
+before then cancels its counter. Other keys are not delayed by a chattering key.
+*/
+
+#include "debounce_counters.h"
+
+void debounce_init(uint8_t num_rows)
+{
+  debounce_counters_init(num_rows);
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed)
+{
+  uint8_t current_time;
+  if (!debounce_scan_needed(changed, &current_time))
+  {
+    return;
+  }
+  uint8_t oldest_age = 0;
+  for (uint8_t row = 0; row < num_rows; row++)
+  {
+    if (!debounce_row_needed(raw[row], cooked[row], row))
+    {
+      continue;
+    }
+    uint16_t index = row * MATRIX_COLS;
+    matrix_row_t delta = raw[row] ^ cooked[row];
+    matrix_row_t existing_row = cooked[row];
+    bool live = false;
+
+    for (uint8_t col = 0; col < MATRIX_COLS; col++)
+    {
+      matrix_row_t col_mask = (ROW_SHIFTER << col);
+      if (delta & col_mask)
+      {
+        debounce_counter_t counter = debounce_counter_get(index);
+        if (counter == DEBOUNCE_ELAPSED)
+        {
+          counter = current_time;
+          debounce_counter_set(index, counter);
+        }
+        // checked right away too, so DEBOUNCE 0 doesn't cost a scan
+        if (debounce_counter_expired(counter, current_time))
+        {
+          debounce_counter_set(index, DEBOUNCE_ELAPSED);
+          existing_row ^= col_mask; //flip the bit.
+        }
+        else
+        {
+          live = true;
+          debounce_counter_running(counter, current_time, &oldest_age);
+        }
+      }
+      else if (debounce_counter_get(index) != DEBOUNCE_ELAPSED)
+      {
+        // bounced back to the debounced state
+        debounce_counter_set(index, DEBOUNCE_ELAPSED);
+      }
+      index++;
+    }
+    cooked[row] = existing_row;
+    debounce_row_set_live(row, live);
+  }
+  debounce_scan_done(current_time, oldest_age);
+}
+
+bool debounce_active(void)
+{
+  return true;
+}
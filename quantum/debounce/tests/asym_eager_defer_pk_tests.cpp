@@ -0,0 +1,74 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debounce_test_common.h"
+
+typedef std::vector<MatrixEdge> Edges;
+
+class AsymEagerDeferPk : public DebounceTest {};
+
+TEST_F(AsymEagerDeferPk, PressIsPushedRightAwayAndReleaseAfterDebounce) {
+    Edges raw = {down(0, 0, 0), up(50, 0, 0)};
+    Edges expected = {down(0, 0, 0), up(50 + DEBOUNCE, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, ChatterOnPressIsIgnored) {
+    Edges raw;
+    chatter(raw, 10, 1, 2, 5);
+    Edges expected = {down(10, 1, 2)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, ChatterOnReleaseDoesntPressAgain) {
+    Edges raw = {down(0, 0, 0), up(30, 0, 0), down(31, 0, 0), up(32, 0, 0), down(33, 0, 0), up(35, 0, 0)};
+    Edges expected = {down(0, 0, 0), up(35 + DEBOUNCE, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, DropoutWhileHeldIsIgnored) {
+    Edges raw = {down(0, 3, 9), up(20, 3, 9), down(20 + DEBOUNCE - 1, 3, 9), up(80, 3, 9)};
+    Edges expected = {down(0, 3, 9), up(80 + DEBOUNCE, 3, 9)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, ReleaseDuringTheLockoutIsDeferredAfterIt) {
+    Edges raw = {down(10, 0, 3), up(12, 0, 3)};
+    // the release is timed from the end of the lockout
+    Edges expected = {down(10, 0, 3), up(10 + DEBOUNCE + DEBOUNCE, 0, 3)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, ChatteringKeyDoesntDelayOtherKeys) {
+    Edges raw;
+    chatter(raw, 0, 0, 0, 30, 2);
+    raw.push_back(down(11, 2, 5));
+    raw.push_back(up(40, 2, 5));
+    Edges expected = {down(0, 0, 0), down(11, 2, 5), up(40 + DEBOUNCE, 2, 5), up(58 + DEBOUNCE, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(AsymEagerDeferPk, SlowScanLoopOnlyDelaysTheRelease) {
+    for (uint32_t period : {3, 5, 15, 16, 300}) {
+        SCOPED_TRACE(period);
+        reset();
+        // released a few scans after the press went through
+        uint32_t release = 2 * DEBOUNCE + 3 * period + 1;
+        Edges raw = {down(0, 0, 0), up(release, 0, 0)};
+        Edges expected = {down(0, 0, 0), up(scan_at(scan_at(release, period) + DEBOUNCE, period), 0, 0)};
+        EXPECT_EQ(expected, run(raw, release + 4 * period + DEBOUNCE, period));
+    }
+}
@@ -0,0 +1,31 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUANTUM_DEBOUNCE_TESTS_CONFIG_H_
+#define QUANTUM_DEBOUNCE_TESTS_CONFIG_H_
+
+// The benchmarks set their own matrix size
+#ifndef MATRIX_ROWS
+#define MATRIX_ROWS 4
+#define MATRIX_COLS 10
+#endif
+
+// The wide counter tests set their own
+#ifndef DEBOUNCE
+#define DEBOUNCE 5
+#endif
+
+#endif /* QUANTUM_DEBOUNCE_TESTS_CONFIG_H_ */
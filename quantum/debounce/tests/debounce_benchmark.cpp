@@ -0,0 +1,93 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The same benchmark is built for several matrix sizes, run
+ * `make test:debounce_bench` to compare the numbers.
+ */
+
+#include "debounce_test_common.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+void advance_time(uint32_t ms);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+const unsigned SCANS = 200000;
+
+// A key goes down or up every TYPING_INTERVAL ms, and chatters for CHATTER ms on every edge
+const unsigned TYPING_INTERVAL = 40;
+const unsigned CHATTER = 3;
+
+}
+
+class DebounceBenchmark : public DebounceTest {
+protected:
+    // Runs SCANS scans and returns the time per scan in ns
+    template <typename RawUpdate>
+    double measure(RawUpdate raw_update) {
+        auto start = bench_clock::now();
+        for (unsigned scan = 0; scan < SCANS; scan++) {
+            bool changed = raw_update(scan);
+            debounce(raw, cooked, MATRIX_ROWS, changed);
+            advance_time(1);
+        }
+        auto elapsed = bench_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / SCANS;
+    }
+
+    matrix_row_t raw[MATRIX_ROWS] = {};
+    matrix_row_t cooked[MATRIX_ROWS] = {};
+};
+
+TEST_F(DebounceBenchmark, Benchmark) {
+    double idle = measure([](unsigned scan) { return false; });
+
+    unsigned keys = 0;
+    double typing = measure([this, &keys](unsigned scan) {
+        unsigned phase = scan % TYPING_INTERVAL;
+        if (phase > CHATTER) {
+            return false;
+        }
+        // every other interval presses the next key, the ones in between release it
+        unsigned key = (scan / (2 * TYPING_INTERVAL)) * 7 % (MATRIX_ROWS * MATRIX_COLS);
+        bool pressed = (scan / TYPING_INTERVAL) % 2 == 0;
+        if (phase < CHATTER && phase % 2 == 1) {
+            pressed = !pressed;
+        }
+        matrix_row_t mask = (matrix_row_t)1 << (key % MATRIX_COLS);
+        matrix_row_t row = pressed ? raw[key / MATRIX_COLS] | mask : raw[key / MATRIX_COLS] & ~mask;
+        bool changed = row != raw[key / MATRIX_COLS];
+        raw[key / MATRIX_COLS] = row;
+        keys += changed && pressed && phase == 0;
+        return changed;
+    });
+
+    // Settle and check that the typing ended with every key released
+    measure([](unsigned scan) { return false; });
+    EXPECT_EQ(SCANS / TYPING_INTERVAL / 2, keys);
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        EXPECT_EQ(0, cooked[row]) << "row " << (int)row;
+    }
+
+    printf("\ndebounce %2ux%-2u idle %6.2f ns, typing %6.2f ns per scan\n\n",
+        (unsigned)MATRIX_ROWS, (unsigned)MATRIX_COLS, idle, typing);
+}
@@ -0,0 +1,86 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debounce_test_common.h"
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+namespace {
+
+// Not a multiple of the counter range, so the timestamps don't start at 0
+const uint32_t START_TIME = 1234;
+
+}
+
+bool operator==(const MatrixEdge& a, const MatrixEdge& b) {
+    return a.time == b.time && a.row == b.row && a.col == b.col && a.pressed == b.pressed;
+}
+
+std::ostream& operator<<(std::ostream& os, const MatrixEdge& edge) {
+    return os << (edge.pressed ? "down" : "up") << "(" << edge.time << ", " << (int)edge.row << ", " << (int)edge.col << ")";
+}
+
+DebounceTest::DebounceTest() {
+    reset();
+}
+
+void DebounceTest::reset() {
+    memset(m_raw, 0, sizeof(m_raw));
+    memset(m_cooked, 0, sizeof(m_cooked));
+    set_time(START_TIME);
+    debounce_init(MATRIX_ROWS);
+}
+
+std::vector<MatrixEdge> DebounceTest::run(std::vector<MatrixEdge> raw, uint32_t duration, uint32_t scan_period) {
+    std::stable_sort(raw.begin(), raw.end(), [](const MatrixEdge& a, const MatrixEdge& b) { return a.time < b.time; });
+    std::vector<MatrixEdge> cooked;
+    auto next = raw.begin();
+    for (uint32_t time = 0; time <= duration; time += scan_period) {
+        bool changed = false;
+        for (; next != raw.end() && next->time <= time; ++next) {
+            matrix_row_t mask = (matrix_row_t)1 << next->col;
+            matrix_row_t row = next->pressed ? m_raw[next->row] | mask : m_raw[next->row] & ~mask;
+            changed |= row != m_raw[next->row];
+            m_raw[next->row] = row;
+        }
+
+        matrix_row_t previous[MATRIX_ROWS];
+        memcpy(previous, m_cooked, sizeof(previous));
+        debounce(m_raw, m_cooked, MATRIX_ROWS, changed);
+
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                matrix_row_t mask = (matrix_row_t)1 << col;
+                if ((previous[row] ^ m_cooked[row]) & mask) {
+                    cooked.push_back(MatrixEdge{time, row, col, (m_cooked[row] & mask) != 0});
+                }
+            }
+        }
+        advance_time(scan_period);
+    }
+    return cooked;
+}
+
+void DebounceTest::chatter(std::vector<MatrixEdge>& raw, uint32_t start, uint8_t row, uint8_t col, unsigned toggles, uint32_t period) {
+    for (unsigned i = 0; i < toggles; i++) {
+        raw.push_back(MatrixEdge{start + i * period, row, col, i % 2 == 0});
+    }
+}
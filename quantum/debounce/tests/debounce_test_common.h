@@ -0,0 +1,70 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUANTUM_DEBOUNCE_TESTS_DEBOUNCE_TEST_COMMON_H_
+#define QUANTUM_DEBOUNCE_TESTS_DEBOUNCE_TEST_COMMON_H_
+
+#include "gtest/gtest.h"
+#include <ostream>
+#include <vector>
+
+extern "C" {
+#include "config.h"
+#include "matrix.h"
+#include "debounce.h"
+}
+
+struct MatrixEdge {
+    uint32_t time;
+    uint8_t row;
+    uint8_t col;
+    bool pressed;
+};
+
+bool operator==(const MatrixEdge& a, const MatrixEdge& b);
+std::ostream& operator<<(std::ostream& os, const MatrixEdge& edge);
+
+inline MatrixEdge down(uint32_t time, uint8_t row, uint8_t col) { return MatrixEdge{time, row, col, true}; }
+inline MatrixEdge up(uint32_t time, uint8_t row, uint8_t col) { return MatrixEdge{time, row, col, false}; }
+
+/* Waveform driven debounce tests
+ *
+ * The raw edges are fed to the debounce algorithm with one scan every
+ * `scan_period` ms, a scan sees all the raw edges since the previous one. The
+ * edges of the debounced matrix are recorded with the time of the scan that
+ * pushed them. Times are relative to the start of the waveform.
+ */
+class DebounceTest : public testing::Test {
+protected:
+    DebounceTest();
+
+    std::vector<MatrixEdge> run(std::vector<MatrixEdge> raw, uint32_t duration, uint32_t scan_period = 1);
+
+    // Starts over with every key up, for tests that run several waveforms
+    void reset();
+
+    // The time of the first scan at or after `time`
+    static uint32_t scan_at(uint32_t time, uint32_t scan_period) { return (time + scan_period - 1) / scan_period * scan_period; }
+
+    // Appends a key that toggles every `period` ms for `toggles` times, starting with a press
+    static void chatter(std::vector<MatrixEdge>& raw, uint32_t start, uint8_t row, uint8_t col, unsigned toggles, uint32_t period = 1);
+
+private:
+    matrix_row_t m_raw[MATRIX_ROWS];
+    matrix_row_t m_cooked[MATRIX_ROWS];
+};
+
+#endif /* QUANTUM_DEBOUNCE_TESTS_DEBOUNCE_TEST_COMMON_H_ */
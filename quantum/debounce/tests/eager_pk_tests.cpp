@@ -0,0 +1,61 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debounce_test_common.h"
+#include <algorithm>
+
+typedef std::vector<MatrixEdge> Edges;
+
+class EagerPk : public DebounceTest {};
+
+TEST_F(EagerPk, EdgesArePushedRightAway) {
+    Edges raw = {down(0, 0, 0), up(50, 0, 0)};
+    Edges expected = {down(0, 0, 0), up(50, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(EagerPk, ChatterAfterAnEdgeIsIgnored) {
+    Edges raw;
+    chatter(raw, 10, 1, 2, 5);
+    Edges expected = {down(10, 1, 2)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(EagerPk, ChangeDuringTheLockoutIsPushedWhenItEnds) {
+    Edges raw = {down(10, 0, 3), up(12, 0, 3)};
+    Edges expected = {down(10, 0, 3), up(10 + DEBOUNCE, 0, 3)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(EagerPk, ChatteringKeyDoesntDelayOtherKeys) {
+    Edges raw;
+    chatter(raw, 0, 0, 0, 30, 2);
+    raw.push_back(down(11, 2, 5));
+    Edges expected = {down(11, 2, 5)};
+    Edges cooked = run(raw, 100);
+    cooked.erase(std::remove_if(cooked.begin(), cooked.end(), [](const MatrixEdge& e) { return e.row == 0; }), cooked.end());
+    EXPECT_EQ(expected, cooked);
+}
+
+TEST_F(EagerPk, SlowScanLoopOnlyDelaysTheLockout) {
+    for (uint32_t period : {3, 5, 15, 16, 300}) {
+        SCOPED_TRACE(period);
+        reset();
+        Edges raw = {down(0, 0, 0), up(2, 0, 0)};
+        Edges expected = {down(0, 0, 0), up(scan_at(std::max<uint32_t>(2, DEBOUNCE), period), 0, 0)};
+        EXPECT_EQ(expected, run(raw, 1000, period));
+    }
+}
@@ -0,0 +1,55 @@
+DEBOUNCE_TEST_SRC :=\
+	$(QUANTUM_PATH)/debounce/tests/debounce_test_common.cpp \
+	$(TMK_PATH)/common/test/timer.c
+
+# Picks up the config.h of the tests
+DEBOUNCE_TEST_INC := $(QUANTUM_PATH)/debounce/tests
+
+debounce_sym_pk_SRC :=\
+	$(DEBOUNCE_TEST_SRC) \
+	$(QUANTUM_PATH)/debounce/tests/sym_pk_tests.cpp \
+	$(QUANTUM_PATH)/debounce/sym_pk.c
+debounce_sym_pk_INC := $(DEBOUNCE_TEST_INC)
+
+debounce_eager_pk_SRC :=\
+	$(DEBOUNCE_TEST_SRC) \
+	$(QUANTUM_PATH)/debounce/tests/eager_pk_tests.cpp \
+	$(QUANTUM_PATH)/debounce/eager_pk.c
+debounce_eager_pk_INC := $(DEBOUNCE_TEST_INC)
+
+debounce_asym_eager_defer_pk_SRC :=\
+	$(DEBOUNCE_TEST_SRC) \
+	$(QUANTUM_PATH)/debounce/tests/asym_eager_defer_pk_tests.cpp \
+	$(QUANTUM_PATH)/debounce/asym_eager_defer_pk.c
+debounce_asym_eager_defer_pk_INC := $(DEBOUNCE_TEST_INC)
+
+# DEBOUNCE 5 packs the counters into 4 bits, the wide groups run the same tests with 8-bit counters
+debounce_eager_pk_packed_limit_SRC := $(debounce_eager_pk_SRC)
+debounce_eager_pk_packed_limit_INC := $(DEBOUNCE_TEST_INC)
+debounce_eager_pk_packed_limit_DEFS := -DDEBOUNCE=7
+
+debounce_sym_pk_wide_SRC := $(debounce_sym_pk_SRC)
+debounce_sym_pk_wide_INC := $(DEBOUNCE_TEST_INC)
+debounce_sym_pk_wide_DEFS := -DDEBOUNCE=20
+
+debounce_asym_eager_defer_pk_wide_SRC := $(debounce_asym_eager_defer_pk_SRC)
+debounce_asym_eager_defer_pk_wide_INC := $(DEBOUNCE_TEST_INC)
+debounce_asym_eager_defer_pk_wide_DEFS := -DDEBOUNCE=20
+
+# The benchmarks run eager_pk from a small split half up to the largest matrix
+DEBOUNCE_BENCH_SRC :=\
+	$(DEBOUNCE_TEST_SRC) \
+	$(QUANTUM_PATH)/debounce/tests/debounce_benchmark.cpp \
+	$(QUANTUM_PATH)/debounce/eager_pk.c
+
+debounce_bench_4x12_SRC := $(DEBOUNCE_BENCH_SRC)
+debounce_bench_4x12_INC := $(DEBOUNCE_TEST_INC)
+debounce_bench_4x12_DEFS := -DMATRIX_ROWS=4 -DMATRIX_COLS=12
+
+debounce_bench_6x21_SRC := $(DEBOUNCE_BENCH_SRC)
+debounce_bench_6x21_INC := $(DEBOUNCE_TEST_INC)
+debounce_bench_6x21_DEFS := -DMATRIX_ROWS=6 -DMATRIX_COLS=21
+
+debounce_bench_16x32_SRC := $(DEBOUNCE_BENCH_SRC)
+debounce_bench_16x32_INC := $(DEBOUNCE_TEST_INC)
+debounce_bench_16x32_DEFS := -DMATRIX_ROWS=16 -DMATRIX_COLS=32
@@ -0,0 +1,81 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debounce_test_common.h"
+
+typedef std::vector<MatrixEdge> Edges;
+
+class SymPk : public DebounceTest {};
+
+TEST_F(SymPk, CleanEdgesArePushedAfterDebounce) {
+    Edges raw = {down(0, 0, 0), up(50, 0, 0)};
+    Edges expected = {down(DEBOUNCE, 0, 0), up(50 + DEBOUNCE, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, ChatterOnPressIsFiltered) {
+    Edges raw;
+    // down, up, down, up, down at 1 ms intervals, then held
+    chatter(raw, 10, 1, 2, 5);
+    Edges expected = {down(14 + DEBOUNCE, 1, 2)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, ChatterOnReleaseIsFiltered) {
+    Edges raw = {down(0, 0, 0), up(30, 0, 0), down(31, 0, 0), up(32, 0, 0), down(33, 0, 0), up(35, 0, 0)};
+    Edges expected = {down(DEBOUNCE, 0, 0), up(35 + DEBOUNCE, 0, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, GlitchShorterThanDebounceIsIgnored) {
+    Edges raw = {down(10, 3, 9), up(10 + DEBOUNCE - 1, 3, 9)};
+    EXPECT_EQ(Edges{}, run(raw, 100));
+}
+
+TEST_F(SymPk, ChatteringKeyDoesntDelayOtherKeys) {
+    Edges raw;
+    // A key that chatters for 60 ms without ever settling
+    chatter(raw, 0, 0, 0, 30, 2);
+    raw.push_back(down(10, 2, 5));
+    raw.push_back(up(40, 2, 5));
+    Edges expected = {down(10 + DEBOUNCE, 2, 5), up(40 + DEBOUNCE, 2, 5)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, KeysInTheSameRowAreIndependent) {
+    Edges raw = {down(0, 1, 0), down(2, 1, 1), up(4, 1, 0), down(8, 1, 0)};
+    Edges expected = {down(2 + DEBOUNCE, 1, 1), down(8 + DEBOUNCE, 1, 0)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, EveryRunningCounterExpires) {
+    // the second counter is started while the first one runs and expires after it
+    Edges raw = {down(0, 0, 0), down(3, 3, 1), up(4, 0, 0)};
+    Edges expected = {down(3 + DEBOUNCE, 3, 1)};
+    EXPECT_EQ(expected, run(raw, 100));
+}
+
+TEST_F(SymPk, SlowScanLoopOnlyDelaysTheEdges) {
+    for (uint32_t period : {3, 5, 15, 16, 300}) {
+        SCOPED_TRACE(period);
+        reset();
+        // released a few scans after the press went through
+        uint32_t release = 2 * DEBOUNCE + 3 * period + 1;
+        Edges raw = {down(0, 0, 0), up(release, 0, 0)};
+        Edges expected = {down(scan_at(DEBOUNCE, period), 0, 0), up(scan_at(scan_at(release, period) + DEBOUNCE, period), 0, 0)};
+        EXPECT_EQ(expected, run(raw, release + 4 * period + DEBOUNCE, period));
+    }
+}
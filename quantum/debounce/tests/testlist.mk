@@ -0,0 +1,10 @@
+TEST_LIST +=\
+	debounce_sym_pk\
+	debounce_eager_pk\
+	debounce_eager_pk_packed_limit\
+	debounce_asym_eager_defer_pk\
+	debounce_sym_pk_wide\
+	debounce_asym_eager_defer_pk_wide\
+	debounce_bench_4x12\
+	debounce_bench_6x21\
+	debounce_bench_16x32
@@ -20,6 +20,7 @@
 #include "progmem.h" // to read default from flash
 #include "quantum.h" // for send_string()
 #include "dynamic_keymap.h"
+#include <string.h>
 
 #ifdef DYNAMIC_KEYMAP_ENABLE
 
@@ -43,6 +44,83 @@
 #error DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE not defined
 #endif
 
+#define DYNAMIC_KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+#ifdef DYNAMIC_KEYMAP_CACHE
+
+#include "deadline.h"
+
+#ifndef DYNAMIC_KEYMAP_WRITE_DELAY
+#define DYNAMIC_KEYMAP_WRITE_DELAY 1000
+#endif
+
+// RAM copy of the keymap in EEPROM, all lookups are served from here.
+// Changes are written back to EEPROM once no further change came in
+// for DYNAMIC_KEYMAP_WRITE_DELAY milliseconds.
+static uint16_t keymap_cache[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS];
+static uint8_t keymap_cache_dirty[(DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS + 7) / 8];
+static bool keymap_cache_loaded = false;
+
+static deadline_t keymap_cache_deadline = DEADLINE(dynamic_keymap_flush);
+
+static void dynamic_keymap_cache_load(void)
+{
+	uint8_t *address = (uint8_t *)DYNAMIC_KEYMAP_EEPROM_ADDR;
+	uint16_t *keycode = &keymap_cache[0][0][0];
+	for ( uint16_t i = 0; i < DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS; i++ ) {
+		// Big endian, so we can read/write EEPROM directly from host if we want
+		*keycode = eeprom_read_byte(address) << 8;
+		*keycode |= eeprom_read_byte(address + 1);
+		keycode++;
+		address += 2;
+	}
+	keymap_cache_loaded = true;
+}
+
+static uint16_t *dynamic_keymap_cache_entry(uint8_t layer, uint8_t row, uint8_t column)
+{
+	if ( !keymap_cache_loaded ) {
+		dynamic_keymap_cache_load();
+	}
+	return &keymap_cache[layer][row][column];
+}
+
+static void dynamic_keymap_cache_update(uint16_t index, uint16_t keycode)
+{
+	uint16_t *entry = &keymap_cache[0][0][0] + index;
+	if ( *entry != keycode ) {
+		*entry = keycode;
+		keymap_cache_dirty[index / 8] |= 1 << (index % 8);
+		// Every further change postpones the write, so edits are written in one batch
+		deadline_set(&keymap_cache_deadline, timer_read(), DYNAMIC_KEYMAP_WRITE_DELAY);
+	}
+}
+
+void dynamic_keymap_flush(void)
+{
+	deadline_cancel(&keymap_cache_deadline);
+	uint16_t *keycode = &keymap_cache[0][0][0];
+	uint8_t *address = (uint8_t *)DYNAMIC_KEYMAP_EEPROM_ADDR;
+	for ( uint16_t i = 0; i < DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS; i++ ) {
+		if ( keymap_cache_dirty[i / 8] & (1 << (i % 8)) ) {
+			// One aligned 16 bit write where the EEPROM supports it
+			uint8_t bytes[2] = { (uint8_t)(*keycode >> 8), (uint8_t)(*keycode & 0xFF) };
+			eeprom_update_block(bytes, address, 2);
+		}
+		keycode++;
+		address += 2;
+	}
+	memset(keymap_cache_dirty, 0, sizeof(keymap_cache_dirty));
+}
+
+#else
+
+void dynamic_keymap_flush(void)
+{
+}
+
+#endif // DYNAMIC_KEYMAP_CACHE
+
 uint8_t dynamic_keymap_get_layer_count(void)
 {
 	return DYNAMIC_KEYMAP_LAYER_COUNT;
@@ -57,19 +135,29 @@ void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t c
 
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column)
 {
+#ifdef DYNAMIC_KEYMAP_CACHE
+	return *dynamic_keymap_cache_entry(layer, row, column);
+#else
 	void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
 	// Big endian, so we can read/write EEPROM directly from host if we want
 	uint16_t keycode = eeprom_read_byte(address) << 8;
 	keycode |= eeprom_read_byte(address + 1);
 	return keycode;
+#endif
 }
 
 void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode)
 {
+#ifdef DYNAMIC_KEYMAP_CACHE
+	dynamic_keymap_cache_entry(layer, row, column);
+	dynamic_keymap_cache_update(( layer * MATRIX_ROWS + row ) * MATRIX_COLS + column, keycode);
+#else
 	void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
 	// Big endian, so we can read/write EEPROM directly from host if we want
 	eeprom_update_byte(address, (uint8_t)(keycode >> 8));
 	eeprom_update_byte(address+1, (uint8_t)(keycode & 0xFF));
+#endif
+	invalidate_resolved_layer((keypos_t){ .row = row, .col = column });
 }
 
 void dynamic_keymap_reset(void)
@@ -86,36 +174,66 @@ void dynamic_keymap_reset(void)
 	}
 }
 
+// Size of the part of a buffer transfer that falls into an EEPROM area of `area_size` bytes
+static uint16_t dynamic_keymap_buffer_size( uint16_t offset, uint16_t size, uint16_t area_size )
+{
+	if ( offset >= area_size ) {
+		return 0;
+	}
+	return size < area_size - offset ? size : area_size - offset;
+}
+
+#ifdef DYNAMIC_KEYMAP_CACHE
+
 void dynamic_keymap_get_buffer( uint16_t offset, uint16_t size, uint8_t *data )
 {
-	uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-	void *source = (void*)(DYNAMIC_KEYMAP_EEPROM_ADDR+offset);
-	uint8_t *target = data;
-	for ( uint16_t i = 0; i < size; i++ ) {
-		if ( offset + i < dynamic_keymap_eeprom_size ) {
-			*target = eeprom_read_byte(source);
-		} else {
-			*target = 0x00;
-		}
-		source++;
-		target++;
+	dynamic_keymap_cache_entry(0, 0, 0);
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_EEPROM_SIZE);
+	for ( uint16_t i = 0; i < in_range; i++ ) {
+		uint16_t byte = offset + i;
+		// Same big endian layout as in EEPROM
+		uint16_t keycode = (&keymap_cache[0][0][0])[byte / 2];
+		data[i] = byte % 2 ? keycode & 0xFF : keycode >> 8;
 	}
+	memset(data + in_range, 0x00, size - in_range);
 }
 
 void dynamic_keymap_set_buffer( uint16_t offset, uint16_t size, uint8_t *data )
 {
-	uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-	void *target = (void*)(DYNAMIC_KEYMAP_EEPROM_ADDR+offset);
-	uint8_t *source = data;
-	for ( uint16_t i = 0; i < size; i++ ) {
-		if ( offset + i < dynamic_keymap_eeprom_size ) {
-			eeprom_update_byte(target, *source);
+	dynamic_keymap_cache_entry(0, 0, 0);
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_EEPROM_SIZE);
+	for ( uint16_t i = 0; i < in_range; i++ ) {
+		uint16_t byte = offset + i;
+		uint16_t keycode = (&keymap_cache[0][0][0])[byte / 2];
+		if ( byte % 2 ) {
+			keycode = ( keycode & 0xFF00 ) | data[i];
+		} else {
+			keycode = ( keycode & 0x00FF ) | ( data[i] << 8 );
 		}
-		source++;
-		target++;
+		dynamic_keymap_cache_update(byte / 2, keycode);
 	}
+	clear_resolved_layers_cache();
 }
 
+#else
+
+void dynamic_keymap_get_buffer( uint16_t offset, uint16_t size, uint8_t *data )
+{
+	// Block transfers let the EEPROM driver use its word sized accesses
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_EEPROM_SIZE);
+	eeprom_read_block(data, ((void*)DYNAMIC_KEYMAP_EEPROM_ADDR)+offset, in_range);
+	memset(data + in_range, 0x00, size - in_range);
+}
+
+void dynamic_keymap_set_buffer( uint16_t offset, uint16_t size, uint8_t *data )
+{
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_EEPROM_SIZE);
+	eeprom_update_block(data, ((void*)DYNAMIC_KEYMAP_EEPROM_ADDR)+offset, in_range);
+	clear_resolved_layers_cache();
+}
+
+#endif // DYNAMIC_KEYMAP_CACHE
+
 // This overrides the one in quantum/keymap_common.c
 uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key)
 {
@@ -142,30 +260,15 @@ uint16_t dynamic_keymap_macro_get_buffer_size(void)
 
 void dynamic_keymap_macro_get_buffer( uint16_t offset, uint16_t size, uint8_t *data )
 {
-	void *source = (void*)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR+offset);
-	uint8_t *target = data;
-	for ( uint16_t i = 0; i < size; i++ ) {
-		if ( offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE ) {
-			*target = eeprom_read_byte(source);
-		} else {
-			*target = 0x00;
-		}
-		source++;
-		target++;
-	}
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
+	eeprom_read_block(data, ((void*)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR)+offset, in_range);
+	memset(data + in_range, 0x00, size - in_range);
 }
 
 void dynamic_keymap_macro_set_buffer( uint16_t offset, uint16_t size, uint8_t *data )
 {
-	void *target = (void*)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR+offset);
-	uint8_t *source = data;
-	for ( uint16_t i = 0; i < size; i++ ) {
-		if ( offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE ) {
-			eeprom_update_byte(target, *source);
-		}
-		source++;
-		target++;
-	}
+	uint16_t in_range = dynamic_keymap_buffer_size(offset, size, DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
+	eeprom_update_block(data, ((void*)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR)+offset, in_range);
 }
 
 void dynamic_keymap_macro_reset(void)
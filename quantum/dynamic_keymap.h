@@ -34,6 +34,13 @@ void dynamic_keymap_reset(void);
 void dynamic_keymap_get_buffer( uint16_t offset, uint16_t size, uint8_t *data );
 void dynamic_keymap_set_buffer( uint16_t offset, uint16_t size, uint8_t *data );
 
+// With DYNAMIC_KEYMAP_CACHE defined, the keymap is kept in RAM and changes
+// are written to EEPROM after DYNAMIC_KEYMAP_WRITE_DELAY milliseconds without
+// further changes. This writes pending changes right away, e.g. before
+// jumping to the bootloader or when the host suspends the keyboard. Does
+// nothing without the cache.
+void dynamic_keymap_flush(void);
+
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
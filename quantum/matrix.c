@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "wait.h"
 #include "print.h"
 #include "debug.h"
@@ -54,6 +55,42 @@ static const pin_t col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
 static matrix_row_t raw_matrix[MATRIX_ROWS]; //raw values
 static matrix_row_t matrix[MATRIX_ROWS]; //debounced values
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+/* Once every key has been up for MATRIX_SCAN_IDLE_TIMEOUT ms all the outputs
+ * are driven at once and scanning stops. The inputs are only polled, or watched
+ * by pin interrupts, until a press pulls one of them low.
+ */
+#    ifndef MATRIX_SCAN_IDLE_TIMEOUT
+#        define MATRIX_SCAN_IDLE_TIMEOUT 50
+#    endif
+#    if defined(DEBOUNCE) && (MATRIX_SCAN_IDLE_TIMEOUT <= DEBOUNCE)
+#        error "MATRIX_SCAN_IDLE_TIMEOUT has to be longer than DEBOUNCE"
+#    endif
+#    if (DIODE_DIRECTION == COL2ROW)
+#        define MATRIX_OUTPUT_PINS row_pins
+#        define MATRIX_OUTPUTS MATRIX_ROWS
+#        define MATRIX_INPUT_PINS col_pins
+#        define MATRIX_INPUTS MATRIX_COLS
+#    elif (DIODE_DIRECTION == ROW2COL)
+#        define MATRIX_OUTPUT_PINS col_pins
+#        define MATRIX_OUTPUTS MATRIX_COLS
+#        define MATRIX_INPUT_PINS row_pins
+#        define MATRIX_INPUTS MATRIX_ROWS
+#    endif
+#    if defined(PROTOCOL_CHIBIOS) && defined(PAL_USE_CALLBACKS) && (PAL_USE_CALLBACKS == TRUE)
+#        define MATRIX_WAKEUP_PAL_EVENTS
+#    endif
+
+static volatile bool matrix_wakeup = false;
+static bool matrix_sleeping = false;
+static uint16_t matrix_last_activity = 0;
+
+static void matrix_sleep(void);
+static bool matrix_wakeup_pending(void);
+static void matrix_wake(void);
+static bool matrix_raw_idle(void);
+#endif
+
 #if (DIODE_DIRECTION == COL2ROW)
     static void init_cols(void);
     static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row);
@@ -124,6 +161,10 @@ void matrix_init(void) {
     }
     debounce_init(MATRIX_ROWS);
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+    matrix_last_activity = timer_read();
+#endif
+
     matrix_init_quantum();
 }
 
@@ -131,6 +172,16 @@ uint8_t matrix_scan(void)
 {
   bool changed = false;
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+  if (matrix_sleeping) {
+    if (!matrix_wakeup_pending()) {
+      matrix_scan_quantum();
+      return 1;
+    }
+    matrix_wake();
+  }
+#endif
+
 #if (DIODE_DIRECTION == COL2ROW)
   // Set row, read cols
   for (uint8_t current_row = 0; current_row < MATRIX_ROWS; current_row++) {
@@ -145,6 +196,15 @@ uint8_t matrix_scan(void)
 
   debounce(raw_matrix, matrix, MATRIX_ROWS, changed);
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+  // Keep scanning while a key is down, its release doesn't cause an edge on the inputs
+  if (changed || !matrix_raw_idle()) {
+    matrix_last_activity = timer_read();
+  } else if (timer_elapsed(matrix_last_activity) >= MATRIX_SCAN_IDLE_TIMEOUT) {
+    matrix_sleep();
+  }
+#endif
+
   matrix_scan_quantum();
   return 1;
 }
@@ -198,11 +258,117 @@ uint8_t matrix_key_count(void)
 
 #if (DIODE_DIRECTION == COL2ROW)
 
+#if defined(MATRIX_COL_PORT_READS) && (defined(__AVR__) || defined(PROTOCOL_CHIBIOS))
+/* The columns that share a port, and whose pads are the same distance from
+ * their column index, are read together with one mask and one shift. Pads
+ * that count down while the columns count up form a reversed group, whose
+ * pads are bit reversed before the shift. The groups of a port are kept next
+ * to each other, so that every port register is read once per row. Pins that
+ * are scattered over too many groups fall back to reading one pin at a time.
+ */
+#    define MATRIX_COL_PORT_READ_ENABLE
+#    ifdef __AVR__
+#        define pin_port(pin) ((pin) >> PORT_SHIFTER)
+#        define pin_pad(pin) ((pin) & 0xF)
+#        define read_port(pin) PIN_ADDRESS(pin, 0)
+#        define reverse_pads(pads) bitrev(pads)
+#        define LAST_PAD 7
+#    else
+#        define pin_port(pin) PAL_PORT(pin)
+#        define pin_pad(pin) PAL_PAD(pin)
+#        define read_port(pin) palReadPort(PAL_PORT(pin))
+#        define reverse_pads(pads) bitrev32(pads)
+#        define LAST_PAD 31
+#    endif
+
+typedef struct {
+    pin_t port_pin;     // any pin of the group, selects the port register
+    bool new_port;      // the port differs from the one of the previous group
+    bool reversed;      // the pads count down while the column index counts up
+    int8_t shift;       // column index minus pad, minus LAST_PAD - pad when reversed
+    uint32_t pads;      // mask of the pads in the group
+} col_group_t;
+
+static col_group_t col_groups[MATRIX_COLS];
+static uint8_t col_group_count = 0;
+
+static void init_col_groups(void)
+{
+    col_group_count = 0;
+    for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        pin_t pin = col_pins[col];
+        int8_t shift = (int8_t)col - (int8_t)pin_pad(pin);
+        int8_t reversed_shift = (int8_t)col - (LAST_PAD - (int8_t)pin_pad(pin));
+        uint8_t group = col_group_count;
+        uint8_t after_port = col_group_count;
+        uint8_t single_pad = col_group_count;
+        for (uint8_t i = 0; i < col_group_count; i++) {
+            col_group_t *other = &col_groups[i];
+            if (pin_port(other->port_pin) == pin_port(pin)) {
+                after_port = i + 1;
+                if (other->shift == (other->reversed ? reversed_shift : shift)) {
+                    group = i;
+                    break;
+                }
+                // a group of one pin can still turn out to be reversed
+                int8_t other_pad = (int8_t)pin_pad(other->port_pin);
+                if (!other->reversed && other->pads == (uint32_t)1 << other_pad
+                    && other->shift + other_pad - (LAST_PAD - other_pad) == reversed_shift) {
+                    single_pad = i;
+                }
+            }
+        }
+        if (group == col_group_count && single_pad != col_group_count) {
+            group = single_pad;
+            col_groups[group].reversed = true;
+            col_groups[group].shift = reversed_shift;
+        }
+        if (group == col_group_count) {
+            // insert behind the last group of the same port
+            group = after_port;
+            memmove(&col_groups[group + 1], &col_groups[group], (col_group_count - group) * sizeof(col_group_t));
+            col_groups[group] = (col_group_t){ .port_pin = pin, .reversed = false, .shift = shift, .pads = 0 };
+            col_group_count++;
+        }
+        col_groups[group].pads |= (uint32_t)1 << pin_pad(pin);
+    }
+    for (uint8_t i = 0; i < col_group_count; i++) {
+        col_groups[i].new_port = i == 0 || pin_port(col_groups[i].port_pin) != pin_port(col_groups[i - 1].port_pin);
+    }
+    // one pin per group isn't any faster than readPin()
+    if (col_group_count > MATRIX_COLS / 2) {
+        col_group_count = 0;
+    }
+}
+
+static matrix_row_t read_col_groups(void)
+{
+    matrix_row_t cols = 0;
+    uint32_t port_state = 0;
+    for (uint8_t i = 0; i < col_group_count; i++) {
+        col_group_t *group = &col_groups[i];
+        if (group->new_port) {
+            // keys pull the columns low
+            port_state = ~(uint32_t)read_port(group->port_pin);
+        }
+        uint32_t pads = port_state & group->pads;
+        if (group->reversed) {
+            pads = reverse_pads(pads);
+        }
+        cols |= (matrix_row_t)(group->shift >= 0 ? pads << group->shift : pads >> -group->shift);
+    }
+    return cols;
+}
+#endif
+
 static void init_cols(void)
 {
     for(uint8_t x = 0; x < MATRIX_COLS; x++) {
         setPinInputHigh(col_pins[x]);
     }
+#ifdef MATRIX_COL_PORT_READ_ENABLE
+    init_col_groups();
+#endif
 }
 
 static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
@@ -217,6 +383,11 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     select_row(current_row);
     wait_us(30);
 
+#ifdef MATRIX_COL_PORT_READ_ENABLE
+    if (col_group_count) {
+        current_matrix[current_row] = read_col_groups();
+    } else
+#endif
     // For each col...
     for(uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++) {
 
@@ -319,3 +490,96 @@ static void unselect_cols(void)
 }
 
 #endif
+
+#ifdef MATRIX_SCAN_ON_CHANGE
+
+#ifdef MATRIX_WAKEUP_PAL_EVENTS
+static void matrix_wakeup_callback(void *arg)
+{
+    (void)arg;
+    matrix_wakeup_isr();
+}
+#endif
+
+__attribute__ ((weak))
+void matrix_wakeup_enable(void)
+{
+#ifdef MATRIX_WAKEUP_PAL_EVENTS
+    for(uint8_t x = 0; x < MATRIX_INPUTS; x++) {
+        palEnableLineEvent(MATRIX_INPUT_PINS[x], PAL_EVENT_MODE_FALLING_EDGE);
+        palSetLineCallback(MATRIX_INPUT_PINS[x], matrix_wakeup_callback, NULL);
+    }
+#endif
+}
+
+__attribute__ ((weak))
+void matrix_wakeup_disable(void)
+{
+#ifdef MATRIX_WAKEUP_PAL_EVENTS
+    for(uint8_t x = 0; x < MATRIX_INPUTS; x++) {
+        palDisableLineEvent(MATRIX_INPUT_PINS[x]);
+    }
+#endif
+}
+
+void matrix_wakeup_isr(void)
+{
+    matrix_wakeup = true;
+}
+
+bool matrix_is_idle(void)
+{
+    return matrix_sleeping;
+}
+
+static bool matrix_raw_idle(void)
+{
+    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+        if (raw_matrix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void matrix_sleep(void)
+{
+    // Drive all outputs, a press on any key then pulls its input low
+    for(uint8_t x = 0; x < MATRIX_OUTPUTS; x++) {
+        setPinOutput(MATRIX_OUTPUT_PINS[x]);
+        writePinLow(MATRIX_OUTPUT_PINS[x]);
+    }
+    wait_us(30);
+
+    matrix_wakeup = false;
+    matrix_wakeup_enable();
+    matrix_sleeping = true;
+}
+
+static bool matrix_wakeup_pending(void)
+{
+    if (matrix_wakeup) {
+        return true;
+    }
+    // Also catches presses on inputs without a working interrupt
+    for(uint8_t x = 0; x < MATRIX_INPUTS; x++) {
+        if (readPin(MATRIX_INPUT_PINS[x]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void matrix_wake(void)
+{
+    matrix_wakeup_disable();
+#if (DIODE_DIRECTION == COL2ROW)
+    unselect_rows();
+#elif (DIODE_DIRECTION == ROW2COL)
+    unselect_cols();
+#endif
+    matrix_sleeping = false;
+    matrix_last_activity = timer_read();
+}
+
+#endif
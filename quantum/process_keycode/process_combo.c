@@ -16,6 +16,7 @@
 
 #include "process_combo.h"
 #include "print.h"
+#include "deadline.h"
 
 
 __attribute__ ((weak))
@@ -24,14 +25,34 @@ combo_t key_combos[COMBO_COUNT] = {
 };
 
 __attribute__ ((weak))
-void process_combo_event(uint8_t combo_index, bool pressed) {
+void process_combo_event(uint16_t combo_index, bool pressed) {
 
 }
 
-static uint8_t current_combo_index = 0;
+/* Every key of the indexed combos, sorted by keycode and then by combo */
+static combo_key_t combo_keys[COMBO_INDEX_SIZE];
+static uint16_t combo_keys_count = 0;
+/* Combos from this one on didn't fit into the index, they are scanned */
+static combo_index_t combos_indexed = 0;
+/* Number of different keys of every combo */
+static uint8_t combo_key_counts[COMBO_COUNT];
 
-static inline void send_combo(uint16_t action, bool pressed)
+/* Presses of combo keys that wait until it's clear which combo they belong to */
+static keyrecord_t key_buffer[COMBO_KEY_BUFFER_LENGTH];
+/* The combo a buffered key was given to, COMBO_COUNT for none */
+static combo_index_t key_buffer_combo[COMBO_KEY_BUFFER_LENGTH];
+static uint8_t key_buffer_size = 0;
+/* Resolves the buffered keys when COMBO_TERM has passed since the first one */
+static deadline_t combo_deadline = DEADLINE(matrix_scan_combo);
+
+/* Keys of pressed combos, their releases are not passed on */
+static keypos_t held_keys[COMBO_KEY_BUFFER_LENGTH];
+static combo_index_t held_keys_combo[COMBO_KEY_BUFFER_LENGTH];
+static uint8_t held_keys_size = 0;
+
+static inline void send_combo(combo_index_t index, bool pressed)
 {
+    uint16_t action = key_combos[index].keycode;
     if (action) {
         if (pressed) {
             register_code16(action);
@@ -39,116 +60,276 @@ static inline void send_combo(uint16_t action, bool pressed)
             unregister_code16(action);
         }
     } else {
-        process_combo_event(current_combo_index, pressed);
+        process_combo_event(index, pressed);
     }
 }
 
-#define ALL_COMBO_KEYS_ARE_DOWN     (((1<<count)-1) == combo->state)
-#define NO_COMBO_KEYS_ARE_DOWN      (0 == combo->state)
-#define KEY_STATE_DOWN(key)         do{ combo->state |= (1<<key); } while(0)
-#define KEY_STATE_UP(key)           do{ combo->state &= ~(1<<key); } while(0)
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) 
+static bool combo_has_key(const combo_t *combo, uint16_t keycode)
 {
-    uint8_t count = 0;
-    uint8_t index = -1;
-    /* Find index of keycode and number of combo keys */
-    for (const uint16_t *keys = combo->keys; ;++count) {
-        uint16_t key = pgm_read_word(&keys[count]);
-        if (keycode == key) index = count;
-        if (COMBO_END == key) break;
-    }
-
-    /* Return if not a combo key */
-    if (-1 == (int8_t)index) return false;
-
-    /* The combos timer is used to signal whether the combo is active */
-    bool is_combo_active = combo->is_active;
-
-    if (record->event.pressed) {
-        KEY_STATE_DOWN(index);
-
-        if (is_combo_active) {
-            if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was pressed */
-                send_combo(combo->keycode, true);
-                combo->is_active = false;
-            } else { /* Combo key was pressed */
-                combo->timer = timer_read();
-                combo->is_active = true;
-#ifdef COMBO_ALLOW_ACTION_KEYS
-                combo->prev_record = *record;
-#else
-                combo->prev_key = keycode;
-#endif
-            }
+    for (const uint16_t *keys = combo->keys; ; ++keys) {
+        uint16_t key = pgm_read_word(keys);
+        if (keycode == key) return true;
+        if (COMBO_END == key) return false;
+    }
+}
+
+/* Returns the first entry of keycode in the index, or combo_keys_count */
+static uint16_t combo_find_first_key(uint16_t keycode)
+{
+    uint16_t low = 0;
+    uint16_t high = combo_keys_count;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (combo_keys[mid].keycode < keycode) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
-    } else {
-        if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was released */
-            send_combo(combo->keycode, false);
+    }
+    return low;
+}
+
+typedef void (*combo_visitor_t)(combo_index_t index);
+
+/* Calls visit for every combo that contains keycode, returns false if there is none */
+static bool for_each_combo_with_key(uint16_t keycode, combo_visitor_t visit)
+{
+    bool found = false;
+
+    for (uint16_t i = combo_find_first_key(keycode); i < combo_keys_count && combo_keys[i].keycode == keycode; ++i) {
+        found = true;
+        if (visit) visit(combo_keys[i].combo);
+    }
+
+    /* The combos that didn't fit into the index */
+    for (combo_index_t i = combos_indexed; i < COMBO_COUNT; ++i) {
+        if (combo_has_key(&key_combos[i], keycode)) {
+            found = true;
+            if (visit) visit(i);
         }
+    }
+
+    return found;
+}
+
+static void combo_key_down(combo_index_t index) { ++key_combos[index].state; }
+static void combo_key_up(combo_index_t index) { --key_combos[index].state; }
 
-        if (is_combo_active) { /* Combo key was tapped */
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            record->event.pressed = true;
-            process_action(record, store_or_get_action(record->event.pressed, record->event.key));
-            record->event.pressed = false;
-            process_action(record, store_or_get_action(record->event.pressed, record->event.key));
-#else
-            register_code16(keycode);
-            send_keyboard_report();
-            unregister_code16(keycode);
-#endif
-            combo->is_active = false;
-            combo->timer = 0;            
+/* Longest combo with all keys in the buffer, COMBO_COUNT if there is none */
+static combo_index_t combo_best;
+/* Most keys of a combo that is only partly in the buffer */
+static uint8_t combo_pending_keys;
+/* Held key slots that are left for combos */
+static uint8_t combo_free_keys;
+
+static void combo_rate(combo_index_t index)
+{
+    combo_t *combo = &key_combos[index];
+    uint8_t count = combo_key_counts[index];
+
+    if (combo->is_active || count > combo_free_keys) return;
+
+    if (combo->state == count) {
+        if (combo_best == COMBO_COUNT ||
+            count > combo_key_counts[combo_best] ||
+            (count == combo_key_counts[combo_best] && index < combo_best)) {
+            combo_best = index;
         }
+    } else if (combo->state > 0 && count > combo_pending_keys) {
+        combo_pending_keys = count;
+    }
+}
 
-        KEY_STATE_UP(index);        
+/* Rates all combos that contain a buffered key which wasn't given to a combo yet */
+static void combo_rate_buffer(void)
+{
+    combo_best = COMBO_COUNT;
+    combo_pending_keys = 0;
+    for (uint8_t i = 0; i < key_buffer_size; ++i) {
+        if (key_buffer_combo[i] == COMBO_COUNT) {
+            for_each_combo_with_key(key_buffer[i].keycode, combo_rate);
+        }
     }
+}
 
-    if (NO_COMBO_KEYS_ARE_DOWN) {
-        combo->is_active = true;
-        combo->timer = 0;
+static bool key_buffer_has_keycode(uint16_t keycode)
+{
+    for (uint8_t i = 0; i < key_buffer_size; ++i) {
+        if (key_buffer[i].keycode == keycode) return true;
     }
+    return false;
+}
 
-    return is_combo_active;
+static bool key_buffer_has_key(keypos_t key)
+{
+    for (uint8_t i = 0; i < key_buffer_size; ++i) {
+        if (KEYEQ(key_buffer[i].event.key, key)) return true;
+    }
+    return false;
 }
 
-bool process_combo(uint16_t keycode, keyrecord_t *record)
+/* Presses the longest matching combos and replays the other buffered keys, in the order they were pressed */
+static void combo_resolve(void)
 {
-    bool is_combo_key = false;
+    combo_free_keys = COMBO_KEY_BUFFER_LENGTH - held_keys_size;
+
+    /* Every buffered key is given to the longest combo that has all its keys */
+    for (;;) {
+        combo_rate_buffer();
+        if (combo_best == COMBO_COUNT) break;
+
+        for (uint8_t i = 0; i < key_buffer_size; ++i) {
+            uint16_t keycode = key_buffer[i].keycode;
+            if (key_buffer_combo[i] == COMBO_COUNT && combo_has_key(&key_combos[combo_best], keycode)) {
+                key_buffer_combo[i] = combo_best;
+                for_each_combo_with_key(keycode, combo_key_up);
+            }
+        }
+        combo_free_keys -= combo_key_counts[combo_best];
+    }
+
+    for (uint8_t i = 0; i < key_buffer_size; ++i) {
+        combo_index_t index = key_buffer_combo[i];
+        if (index == COMBO_COUNT) {
+            for_each_combo_with_key(key_buffer[i].keycode, combo_key_up);
+            // The release goes through the whole record chain, so does the press
+            process_record_resume(&key_buffer[i], process_combo);
+            continue;
+        }
 
-    for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
-        combo_t *combo = &key_combos[current_combo_index];
-        is_combo_key |= process_single_combo(combo, keycode, record);
-    }    
+        held_keys[held_keys_size] = key_buffer[i].event.key;
+        held_keys_combo[held_keys_size] = index;
+        ++held_keys_size;
 
-    return !is_combo_key;
+        /* The combo is pressed with its last key */
+        bool is_last_key = true;
+        for (uint8_t j = i + 1; j < key_buffer_size; ++j) {
+            if (key_buffer_combo[j] == index) is_last_key = false;
+        }
+        if (is_last_key) {
+            key_combos[index].is_active = true;
+            send_combo(index, true);
+        }
+    }
+
+    key_buffer_size = 0;
+    deadline_cancel(&combo_deadline);
 }
 
-void matrix_scan_combo(void)
+void combo_init(void)
 {
-    for (int i = 0; i < COMBO_COUNT; ++i) {
+    if (key_buffer_size) combo_resolve();
+
+    combo_keys_count = 0;
+    combos_indexed = COMBO_COUNT;
+
+    for (combo_index_t i = 0; i < COMBO_COUNT; ++i) {
         // Do not treat the (weak) key_combos too strict.
         #pragma GCC diagnostic push
         #pragma GCC diagnostic ignored "-Warray-bounds"
-        combo_t *combo = &key_combos[i];
+        const combo_t *combo = &key_combos[i];
         #pragma GCC diagnostic pop
-        if (combo->is_active &&
-            combo->timer &&
-            timer_elapsed(combo->timer) > COMBO_TERM) {
-
-            /* This disables the combo, meaning key events for this
-             * combo will be handled by the next processors in the chain 
-             */
-            combo->is_active = false;
-
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            process_action(&combo->prev_record, 
-                store_or_get_action(combo->prev_record.event.pressed, 
-                                    combo->prev_record.event.key));
-#else
-            unregister_code16(combo->prev_key);
-            register_code16(combo->prev_key);
-#endif
+
+        uint8_t count = 0;
+        for (uint8_t position = 0; ; ++position) {
+            uint16_t keycode = pgm_read_word(&combo->keys[position]);
+            if (COMBO_END == keycode) break;
+
+            /* A key that occurs twice is only counted once */
+            bool is_repeated = false;
+            for (uint8_t j = 0; j < position; ++j) {
+                if (keycode == pgm_read_word(&combo->keys[j])) is_repeated = true;
+            }
+            if (is_repeated) continue;
+            ++count;
+
+            if (combos_indexed != COMBO_COUNT) continue;
+            if (combo_keys_count == COMBO_INDEX_SIZE) {
+                dprintf("combo: index full at combo %u, increase COMBO_INDEX_SIZE\n", i);
+                /* Drop the keys of this combo that made it into the index */
+                uint16_t kept = 0;
+                for (uint16_t j = 0; j < combo_keys_count; ++j) {
+                    if (combo_keys[j].combo != i) combo_keys[kept++] = combo_keys[j];
+                }
+                combo_keys_count = kept;
+                combos_indexed = i;
+                continue;
+            }
+
+            /* Insertion sort, keys of earlier combos stay in front */
+            uint16_t j = combo_keys_count++;
+            while (j > 0 && combo_keys[j - 1].keycode > keycode) {
+                combo_keys[j] = combo_keys[j - 1];
+                --j;
+            }
+            combo_keys[j] = (combo_key_t){ .keycode = keycode, .combo = i };
+        }
+
+        combo_key_counts[i] = count;
+        if (count > COMBO_KEY_BUFFER_LENGTH) {
+            dprintf("combo: combo %u has more keys than COMBO_KEY_BUFFER_LENGTH\n", i);
         }
     }
 }
+
+bool process_combo(uint16_t keycode, keyrecord_t *record)
+{
+    keypos_t key = record->event.key;
+
+    if (!record->event.pressed) {
+        /* A buffered key is released before its combo was decided */
+        if (key_buffer_has_key(key)) combo_resolve();
+
+        for (uint8_t i = 0; i < held_keys_size; ++i) {
+            if (!KEYEQ(held_keys[i], key)) continue;
+
+            combo_index_t index = held_keys_combo[i];
+            for (--held_keys_size; i < held_keys_size; ++i) {
+                held_keys[i] = held_keys[i + 1];
+                held_keys_combo[i] = held_keys_combo[i + 1];
+            }
+            /* The combo is released with its first key */
+            if (key_combos[index].is_active) {
+                key_combos[index].is_active = false;
+                send_combo(index, false);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    if (!for_each_combo_with_key(keycode, NULL)) {
+        /* Keep the order of the keys */
+        if (key_buffer_size) combo_resolve();
+        return true;
+    }
+
+    if (key_buffer_size == COMBO_KEY_BUFFER_LENGTH || key_buffer_has_keycode(keycode)) {
+        combo_resolve();
+    }
+
+    if (!key_buffer_size) {
+        deadline_set(&combo_deadline, record->event.time, COMBO_TERM + 1);
+    }
+    key_buffer[key_buffer_size] = *record;
+    key_buffer_combo[key_buffer_size] = COMBO_COUNT;
+    ++key_buffer_size;
+    for_each_combo_with_key(keycode, combo_key_down);
+
+    /* Only wait while a longer combo can still be completed */
+    combo_free_keys = COMBO_KEY_BUFFER_LENGTH - held_keys_size;
+    combo_rate_buffer();
+    if (combo_pending_keys <= (combo_best == COMBO_COUNT ? 0 : combo_key_counts[combo_best])) {
+        combo_resolve();
+    }
+
+    return false;
+}
+
+void matrix_scan_combo(void)
+{
+    /* COMBO_TERM counts from the first buffered key */
+    if (key_buffer_size && timer_elapsed(key_buffer[0].event.time) > COMBO_TERM) {
+        combo_resolve();
+    }
+}
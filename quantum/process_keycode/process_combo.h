@@ -20,25 +20,16 @@
 #include <stdint.h>
 #include "progmem.h"
 #include "quantum.h"
+#include "action_tapping.h"
 
 typedef struct
 {
     const uint16_t *keys;
-    uint16_t keycode;        
-#ifdef EXTRA_EXTRA_LONG_COMBOS
-    uint32_t state;
-#elif EXTRA_LONG_COMBOS
-    uint16_t state;
-#else
+    uint16_t keycode;
+    /* number of keys of the combo that are waiting in the key buffer */
     uint8_t state;
-#endif
-    uint16_t timer;
+    /* the combo was pressed and none of its keys was released yet */
     bool is_active;
-#ifdef COMBO_ALLOW_ACTION_KEYS
-    keyrecord_t prev_record;
-#else
-    uint16_t prev_key;
-#endif
 } combo_t;
 
 
@@ -49,12 +40,42 @@ typedef struct
 #ifndef COMBO_COUNT
 #define COMBO_COUNT 0
 #endif
+/* Number of combo keys that fit into the keycode to combo index */
+#ifndef COMBO_INDEX_SIZE
+#define COMBO_INDEX_SIZE (COMBO_COUNT * 3)
+#endif
+
+#if COMBO_COUNT > 255
+typedef uint16_t combo_index_t;
+#else
+typedef uint8_t combo_index_t;
+#endif
+
+/* Entry of the keycode to combo index */
+typedef struct
+{
+    uint16_t keycode;
+    combo_index_t combo;
+} combo_key_t;
+
+/* Number of combo key presses that can wait for a decision, and the most keys a combo can have */
+#ifndef COMBO_KEY_BUFFER_LENGTH
+#if defined(EXTRA_EXTRA_LONG_COMBOS)
+#define COMBO_KEY_BUFFER_LENGTH 32
+#elif defined(EXTRA_LONG_COMBOS)
+#define COMBO_KEY_BUFFER_LENGTH 16
+#else
+#define COMBO_KEY_BUFFER_LENGTH 8
+#endif
+#endif
+
 #ifndef COMBO_TERM
 #define COMBO_TERM TAPPING_TERM
 #endif
 
+void combo_init(void);
 bool process_combo(uint16_t keycode, keyrecord_t *record);
 void matrix_scan_combo(void);
-void process_combo_event(uint8_t combo_index, bool pressed);
+void process_combo_event(uint16_t combo_index, bool pressed);
 
 #endif
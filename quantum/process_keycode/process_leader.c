@@ -17,6 +17,7 @@
 #ifdef LEADER_ENABLE
 
 #include "process_leader.h"
+#include "deadline.h"
 
 #ifndef LEADER_TIMEOUT
   #define LEADER_TIMEOUT 300
@@ -35,6 +36,118 @@ uint16_t leader_time = 0;
 uint16_t leader_sequence[5] = {0, 0, 0, 0, 0};
 uint8_t leader_sequence_size = 0;
 
+#ifdef LEADER_SEQUENCE_COUNT
+/* The leader_sequences sorted by their keys, which makes them a flattened trie:
+ * the sequences that start with the keys typed so far are next to each other,
+ * and every key narrows that range down.
+ */
+static uint8_t sequence_order[LEADER_SEQUENCE_COUNT];
+/* The range of sequence_order that still matches, and the number of keys typed */
+static uint8_t range_first, range_end;
+static uint8_t sequence_depth;
+
+static void leader_timeout(void);
+static deadline_t leader_deadline = DEADLINE(leader_timeout);
+/* Set by the first LEADER_DICTIONARY(), which then ends the sequences outside the table */
+static bool leader_has_dictionary = false;
+
+/* Key `depth` of the sequence at `position`, LEADER_END past its last key */
+static uint16_t sequence_key(uint8_t position, uint8_t depth) {
+  const uint16_t *keys = pgm_read_ptr(&leader_sequences[sequence_order[position]].keys);
+  return pgm_read_word(&keys[depth]);
+}
+
+static bool sequence_less(uint8_t a, uint8_t b) {
+  for (uint8_t depth = 0; ; depth++) {
+    uint16_t key_a = sequence_key(a, depth);
+    uint16_t key_b = sequence_key(b, depth);
+    if (key_a != key_b) { return key_a < key_b; }
+    if (key_a == LEADER_END) { return false; }
+  }
+}
+
+/* First position in the range whose key at sequence_depth isn't below `keycode` */
+static uint8_t lower_bound(uint16_t keycode) {
+  uint8_t first = range_first, end = range_end;
+  while (first < end) {
+    uint8_t middle = first + (end - first) / 2;
+    if (sequence_key(middle, sequence_depth) < keycode) {
+      first = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+  return first;
+}
+
+/* Whether a sequence of the table is exactly the typed keys, sorted in front of the longer ones it comes first */
+static bool leader_exact_match(void) {
+  return range_first < range_end && sequence_key(range_first, sequence_depth) == LEADER_END;
+}
+
+static void leader_finish(void) {
+  deadline_cancel(&leader_deadline);
+  leading = false;
+  if (leader_exact_match()) {
+    void (*function)(void) = (void (*)(void))pgm_read_ptr(&leader_sequences[sequence_order[range_first]].function);
+    if (function) { function(); }
+  }
+  leader_end();
+}
+
+static void leader_timeout(void) {
+  // Keys the table doesn't know are left to LEADER_DICTIONARY()
+  if (leading && (leader_exact_match() || !leader_has_dictionary)) { leader_finish(); }
+}
+
+static void leader_sequence_key(uint16_t keycode) {
+  if (keycode == LEADER_END) {
+    // Ends every sequence, it can't be typed
+    range_first = range_end;
+  } else {
+    range_first = lower_bound(keycode);
+    if (keycode != UINT16_MAX) {
+      range_end = lower_bound(keycode + 1);
+    }
+  }
+  sequence_depth++;
+  if (range_first == range_end) {
+    // No sequence of the table matches, without a LEADER_DICTIONARY() nothing can
+    if (!leader_has_dictionary) { leader_finish(); }
+  } else if (range_end - range_first == 1 && leader_exact_match()) {
+    // Done when one sequence matches and no longer one can
+    leader_finish();
+  }
+}
+#endif
+
+bool leader_dictionary_due(void) {
+#ifdef LEADER_SEQUENCE_COUNT
+  leader_has_dictionary = true;
+  // The table gets its sequences first, however late this runs compared to deadline_task()
+  if (leading && leader_exact_match() && timer_elapsed(leader_time) >= LEADER_TIMEOUT) {
+    leader_finish();
+  }
+#endif
+  return leading && timer_elapsed(leader_time) > LEADER_TIMEOUT;
+}
+
+void leader_init(void) {
+#ifdef LEADER_SEQUENCE_COUNT
+  // Insertion sort, the table is only sorted once
+  for (uint8_t i = 0; i < LEADER_SEQUENCE_COUNT; i++) {
+    uint8_t j = i;
+    sequence_order[j] = i;
+    while (j > 0 && sequence_less(j, j - 1)) {
+      uint8_t swap = sequence_order[j];
+      sequence_order[j] = sequence_order[j - 1];
+      sequence_order[j - 1] = swap;
+      j--;
+    }
+  }
+#endif
+}
+
 void qk_leader_start(void) {
   if (leading) { return; }
   leader_start();
@@ -46,6 +159,12 @@ void qk_leader_start(void) {
   leader_sequence[2] = 0;
   leader_sequence[3] = 0;
   leader_sequence[4] = 0;
+#ifdef LEADER_SEQUENCE_COUNT
+  range_first = 0;
+  range_end = LEADER_SEQUENCE_COUNT;
+  sequence_depth = 0;
+  deadline_set(&leader_deadline, leader_time, LEADER_TIMEOUT);
+#endif
 }
 
 bool process_leader(uint16_t keycode, keyrecord_t *record) {
@@ -58,10 +177,18 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
           keycode = keycode & 0xFF;
         }
 #endif // LEADER_KEY_STRICT_KEY_PROCESSING
-        leader_sequence[leader_sequence_size] = keycode;
-        leader_sequence_size++;
+        if (leader_sequence_size < sizeof(leader_sequence) / sizeof(leader_sequence[0])) {
+          leader_sequence[leader_sequence_size] = keycode;
+          leader_sequence_size++;
+        }
 #ifdef LEADER_PER_KEY_TIMING
         leader_time = timer_read();
+#endif
+#ifdef LEADER_SEQUENCE_COUNT
+  #ifdef LEADER_PER_KEY_TIMING
+        deadline_set(&leader_deadline, leader_time, LEADER_TIMEOUT);
+  #endif
+        leader_sequence_key(keycode);
 #endif
         return false;
       }
@@ -25,6 +25,26 @@ bool process_leader(uint16_t keycode, keyrecord_t *record);
 void leader_start(void);
 void leader_end(void);
 void qk_leader_start(void);
+void leader_init(void);
+/* Whether the typed sequence is left to LEADER_DICTIONARY(), ends a sequence of the table first */
+bool leader_dictionary_due(void);
+
+#ifdef LEADER_SEQUENCE_COUNT
+#if LEADER_SEQUENCE_COUNT > 255
+  #error "LEADER_SEQUENCE_COUNT can't be more than 255"
+#endif
+
+#define LEADER_END 0
+
+typedef struct {
+  const uint16_t *keys;
+  void (*function)(void);
+} leader_sequence_t;
+
+#define LEADER_SEQUENCE(ks, fn) { .keys = &(ks)[0], .function = (fn) }
+
+extern const leader_sequence_t leader_sequences[LEADER_SEQUENCE_COUNT];
+#endif
 
 #define SEQ_ONE_KEY(key) if (leader_sequence[0] == (key) && leader_sequence[1] == 0 && leader_sequence[2] == 0 && leader_sequence[3] == 0 && leader_sequence[4] == 0)
 #define SEQ_TWO_KEYS(key1, key2) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == 0 && leader_sequence[3] == 0 && leader_sequence[4] == 0)
@@ -33,6 +53,6 @@ void qk_leader_start(void);
 #define SEQ_FIVE_KEYS(key1, key2, key3, key4, key5) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == (key5))
 
 #define LEADER_EXTERNS() extern bool leading; extern uint16_t leader_time; extern uint16_t leader_sequence[5]; extern uint8_t leader_sequence_size
-#define LEADER_DICTIONARY() if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT)
+#define LEADER_DICTIONARY() if (leader_dictionary_due())
 
 #endif
@@ -15,6 +15,7 @@
  */
 #include "quantum.h"
 #include "action_tapping.h"
+#include "deadline.h"
 
 #ifndef TAPPING_TERM
 #define TAPPING_TERM 200
@@ -25,7 +26,16 @@ uint8_t get_oneshot_mods(void);
 #endif
 
 static uint16_t last_td;
-static int8_t highest_td = -1;
+
+/* Dances with count > 0, ordered by the time their tapping term runs out.
+ * Pressing any other key finishes all dances that aren't held, so only the held
+ * ones and the latest dance can be active at the same time.
+ */
+static uint8_t active_tds[TAP_DANCE_MAX_ACTIVE];
+static uint16_t active_td_deadlines[TAP_DANCE_MAX_ACTIVE];
+static uint8_t active_td_count;
+
+static deadline_t tap_dance_deadline = DEADLINE(matrix_scan_tap_dance);
 
 void qk_tap_dance_pair_on_each_tap (qk_tap_dance_state_t *state, void *user_data) {
   qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
@@ -83,6 +93,73 @@ void qk_tap_dance_dual_role_reset (qk_tap_dance_state_t *state, void *user_data)
   }
 }
 
+static uint16_t get_tap_dance_term(qk_tap_dance_action_t *action) {
+  if (action->custom_tapping_term > 0) {
+    return action->custom_tapping_term;
+  }
+  return TAPPING_TERM;
+}
+
+/* Waits for the first dance that can still finish, held dances that have finished can't */
+static void update_tap_dance_deadline(void) {
+  for (uint8_t i = 0; i < active_td_count; i++) {
+    qk_tap_dance_action_t *action = &tap_dance_actions[active_tds[i]];
+    if (!action->state.finished) {
+      // finishes once more than the term has passed
+      deadline_set(&tap_dance_deadline, action->state.timer, get_tap_dance_term(action) + 1);
+      return;
+    }
+  }
+  deadline_cancel(&tap_dance_deadline);
+}
+
+static int8_t find_active_tap_dance(uint8_t idx) {
+  for (uint8_t i = 0; i < active_td_count; i++) {
+    if (active_tds[i] == idx) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void remove_active_tap_dance(uint8_t idx) {
+  int8_t pos = find_active_tap_dance(idx);
+  if (pos < 0) {
+    return;
+  }
+  active_td_count--;
+  for (uint8_t i = pos; i < active_td_count; i++) {
+    active_tds[i] = active_tds[i + 1];
+    active_td_deadlines[i] = active_td_deadlines[i + 1];
+  }
+  update_tap_dance_deadline();
+}
+
+static void finish_tap_dance(qk_tap_dance_action_t *action);
+
+/* (Re)inserts a dance, its deadline moves with every tap */
+static void insert_active_tap_dance(uint8_t idx, uint16_t deadline) {
+  remove_active_tap_dance(idx);
+  if (active_td_count == TAP_DANCE_MAX_ACTIVE) {
+    // Too many dances held down, the one that runs out first finishes early
+    finish_tap_dance(&tap_dance_actions[active_tds[0]]);
+    if (active_td_count == TAP_DANCE_MAX_ACTIVE) {
+      remove_active_tap_dance(active_tds[0]);
+    }
+  }
+  uint16_t now = timer_read();
+  uint8_t pos = active_td_count;
+  while (pos > 0 && (int16_t)(active_td_deadlines[pos - 1] - now) > (int16_t)(deadline - now)) {
+    active_tds[pos] = active_tds[pos - 1];
+    active_td_deadlines[pos] = active_td_deadlines[pos - 1];
+    pos--;
+  }
+  active_tds[pos] = idx;
+  active_td_deadlines[pos] = deadline;
+  active_td_count++;
+  update_tap_dance_deadline();
+}
+
 static inline void _process_tap_dance_action_fn (qk_tap_dance_state_t *state,
                                                  void *user_data,
                                                  qk_tap_dance_user_fn_t fn)
@@ -116,25 +193,31 @@ static inline void process_tap_dance_action_on_reset (qk_tap_dance_action_t *act
   send_keyboard_report();
 }
 
+static void finish_tap_dance(qk_tap_dance_action_t *action) {
+  process_tap_dance_action_on_dance_finished (action);
+  reset_tap_dance (&action->state);
+}
+
 void preprocess_tap_dance(uint16_t keycode, keyrecord_t *record) {
   qk_tap_dance_action_t *action;
 
   if (!record->event.pressed)
     return;
 
-  if (highest_td == -1)
-    return;
-
-  for (int i = 0; i <= highest_td; i++) {
-    action = &tap_dance_actions[i];
-    if (action->state.count) {
-      if (keycode == action->state.keycode && keycode == last_td)
-        continue;
-      action->state.interrupted = true;
-      action->state.interrupting_keycode = keycode;
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
+  uint8_t i = 0;
+  while (i < active_td_count) {
+    uint8_t idx = active_tds[i];
+    action = &tap_dance_actions[idx];
+    if (keycode == action->state.keycode && keycode == last_td) {
+      i++;
+      continue;
     }
+    action->state.interrupted = true;
+    action->state.interrupting_keycode = keycode;
+    finish_tap_dance (action);
+    // Held dances stay active until they are released
+    if (i < active_td_count && active_tds[i] == idx)
+      i++;
   }
 }
 
@@ -144,8 +227,6 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
   switch(keycode) {
   case QK_TAP_DANCE ... QK_TAP_DANCE_MAX:
-    if ((int16_t)idx > highest_td)
-      highest_td = idx;
     action = &tap_dance_actions[idx];
 
     action->state.pressed = record->event.pressed;
@@ -153,6 +234,7 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
       action->state.keycode = keycode;
       action->state.count++;
       action->state.timer = timer_read();
+      insert_active_tap_dance(idx, action->state.timer + get_tap_dance_term(action));
 #ifndef NO_ACTION_ONESHOT
       action->state.oneshot_mods = get_oneshot_mods();
 #else
@@ -178,23 +260,18 @@ bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
 
 
 void matrix_scan_tap_dance () {
-  if (highest_td == -1)
-    return;
-  uint16_t tap_user_defined;
-
-  for (uint8_t i = 0; i <= highest_td; i++) {
-    qk_tap_dance_action_t *action = &tap_dance_actions[i];
-    if(action->custom_tapping_term > 0 ) {
-      tap_user_defined = action->custom_tapping_term;
-    }
-    else{
-      tap_user_defined = TAPPING_TERM;
-    }
-    if (action->state.count && timer_elapsed (action->state.timer) > tap_user_defined) {
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
-    }
+  uint8_t i = 0;
+  // Only the dances at the front of the list can have run out
+  while (i < active_td_count) {
+    uint8_t idx = active_tds[i];
+    qk_tap_dance_action_t *action = &tap_dance_actions[idx];
+    if (timer_elapsed (action->state.timer) <= get_tap_dance_term(action))
+      break;
+    finish_tap_dance (action);
+    if (i < active_td_count && active_tds[i] == idx)
+      i++;
   }
+  update_tap_dance_deadline();
 }
 
 void reset_tap_dance (qk_tap_dance_state_t *state) {
@@ -206,6 +283,7 @@ void reset_tap_dance (qk_tap_dance_state_t *state) {
   action = &tap_dance_actions[state->keycode - QK_TAP_DANCE];
 
   process_tap_dance_action_on_reset (action);
+  remove_active_tap_dance(state->keycode - QK_TAP_DANCE);
 
   state->count = 0;
   state->interrupted = false;
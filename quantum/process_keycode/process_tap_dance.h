@@ -21,6 +21,11 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+// The number of tap dances that can be in progress at the same time
+#ifndef TAP_DANCE_MAX_ACTIVE
+#define TAP_DANCE_MAX_ACTIVE 8
+#endif
+
 typedef struct
 {
   uint8_t count;
@@ -27,7 +27,7 @@ static uint8_t selected_index;
 #endif
 
 void unicode_input_mode_init(void) {
-  unicode_config.raw = eeprom_read_byte(EECONFIG_UNICODEMODE);
+  unicode_config.raw = eeconfig_read_byte(EECONFIG_UNICODEMODE);
 #if UNICODE_SELECTED_MODES != -1
   #if UNICODE_CYCLE_PERSIST
   // Find input_mode in selected modes
@@ -72,7 +72,7 @@ void cycle_unicode_input_mode(uint8_t offset) {
 }
 
 void persist_unicode_input_mode(void) {
-  eeprom_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode);
+  eeconfig_update_byte(EECONFIG_UNICODEMODE, unicode_config.input_mode);
 }
 
 static uint8_t saved_mods;
@@ -137,10 +137,79 @@ uint16_t hex_to_keycode(uint8_t hex) {
   }
 }
 
+/* The digits are typed like send_string characters, so keys of consecutive
+ * digits share reports
+ */
+static void tap_hex_digit(uint8_t digit) {
+  uint16_t keycode = hex_to_keycode(digit);
+  if (keycode <= 0xFF) {
+    send_string_tap_code(keycode);
+  } else {
+    send_string_flush();
+    tap_code16(keycode);
+  }
+}
+
 void register_hex(uint16_t hex) {
   for(int i = 3; i >= 0; i--) {
+    tap_hex_digit((hex >> (i*4)) & 0xF);
+  }
+  send_string_flush();
+}
+
+void register_hex32(uint32_t hex) {
+  bool onzerostart = true;
+  for(int i = 7; i >= 0; i--) {
+    if (i <= 3) {
+      onzerostart = false;
+    }
     uint8_t digit = ((hex >> (i*4)) & 0xF);
-    tap_code(hex_to_keycode(digit));
+    if (digit == 0) {
+      if (!onzerostart) {
+        tap_hex_digit(digit);
+      }
+    } else {
+      tap_hex_digit(digit);
+      onzerostart = false;
+    }
+  }
+  send_string_flush();
+}
+
+/* Unicode strings are typed through one writer that starts an input session
+ * for the first code point, and only finishes it when the input mode can't
+ * take another code point. Unicode Hex Input on macOS keeps taking code points
+ * while its key is held, IBus and WinCompose commit and end the session with
+ * the key that finishes a code point, and so does the Windows numpad input.
+ */
+static bool unicode_session_open = false;
+
+static void unicode_write_code_point(uint32_t code_point) {
+  if (!unicode_session_open) {
+    unicode_input_start();
+    unicode_session_open = true;
+  }
+
+  if (unicode_config.input_mode == UC_OSX) {
+    if (code_point > 0xFFFF) {
+      // Unicode Hex Input takes characters outside the BMP as UTF-16 surrogate pairs
+      code_point -= 0x10000;
+      register_hex(0xD800 + (code_point >> 10));
+      register_hex(0xDC00 + (code_point & 0x3FF));
+    } else {
+      register_hex(code_point);
+    }
+  } else {
+    register_hex32(code_point);
+    unicode_input_finish();
+    unicode_session_open = false;
+  }
+}
+
+static void unicode_write_finish(void) {
+  if (unicode_session_open) {
+    unicode_input_finish();
+    unicode_session_open = false;
   }
 }
 
@@ -148,25 +217,71 @@ void send_unicode_hex_string(const char *str) {
   if (!str) { return; }
 
   while (*str) {
-    // Find the next code point (token) in the string
+    // Parse the next code point (token), tokens are separated by spaces
     for (; *str == ' '; str++);
-    size_t n = strcspn(str, " "); // Length of the current token
-    char code_point[n+1];
-    strncpy(code_point, str, n);
-    code_point[n] = '\0'; // Make sure it's null-terminated
-
-    // Normalize the code point: make all hex digits lowercase
-    for (char *p = code_point; *p; p++) {
-      *p = tolower((unsigned char)*p);
+    if (!*str) { break; }
+
+    // Tokens that aren't 1 to 8 hex digits are skipped
+    uint32_t code_point = 0;
+    uint8_t digits = 0;
+    bool valid = true;
+    for (; *str && *str != ' '; str++, digits++) {
+      char c = tolower((unsigned char)*str);
+      if (!isxdigit((unsigned char)c) || digits == 8) {
+        valid = false;
+        continue;
+      }
+      code_point = code_point << 4 | (isdigit((unsigned char)c) ? c - '0' : c - 'a' + 0xA);
     }
+    if (valid) {
+      unicode_write_code_point(code_point);
+    }
+  }
+  unicode_write_finish();
+}
 
-    // Send the code point as a Unicode input string
-    unicode_input_start();
-    send_string(code_point);
-    unicode_input_finish();
+/* Decodes the next UTF-8 sequence of `str`, invalid ones become U+FFFD */
+static const char *decode_utf8(const char *str, uint32_t *code_point) {
+  uint8_t c = *str++;
+  uint8_t length;
 
-    str += n; // Move to the first ' ' (or '\0') after the current token
+  if (c < 0x80) {
+    *code_point = c;
+    return str;
+  } else if ((c & 0xE0) == 0xC0) {
+    *code_point = c & 0x1F;
+    length = 1;
+  } else if ((c & 0xF0) == 0xE0) {
+    *code_point = c & 0x0F;
+    length = 2;
+  } else if ((c & 0xF8) == 0xF0) {
+    *code_point = c & 0x07;
+    length = 3;
+  } else {
+    *code_point = 0xFFFD;
+    return str;
+  }
+
+  for (; length; length--, str++) {
+    if ((*str & 0xC0) != 0x80) {
+      // Truncated sequence, the next byte starts the next character
+      *code_point = 0xFFFD;
+      return str;
+    }
+    *code_point = *code_point << 6 | (*str & 0x3F);
+  }
+  return str;
+}
+
+void send_unicode_string(const char *str) {
+  if (!str) { return; }
+
+  while (*str) {
+    uint32_t code_point;
+    str = decode_utf8(str, &code_point);
+    unicode_write_code_point(code_point);
   }
+  unicode_write_finish();
 }
 
 bool process_unicode_common(uint16_t keycode, keyrecord_t *record) {
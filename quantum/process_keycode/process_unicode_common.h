@@ -74,7 +74,9 @@ void unicode_input_start(void);
 void unicode_input_finish(void);
 
 void register_hex(uint16_t hex);
+void register_hex32(uint32_t hex);
 void send_unicode_hex_string(const char *str);
+void send_unicode_string(const char *str);
 
 bool process_unicode_common(uint16_t keycode, keyrecord_t *record);
 
@@ -17,26 +17,6 @@
 #include "process_unicodemap.h"
 #include "process_unicode_common.h"
 
-void register_hex32(uint32_t hex) {
-  bool onzerostart = true;
-  for(int i = 7; i >= 0; i--) {
-    if (i <= 3) {
-      onzerostart = false;
-    }
-    uint8_t digit = ((hex >> (i*4)) & 0xF);
-    if (digit == 0) {
-      if (!onzerostart) {
-        register_code(hex_to_keycode(digit));
-        unregister_code(hex_to_keycode(digit));
-      }
-    } else {
-      register_code(hex_to_keycode(digit));
-      unregister_code(hex_to_keycode(digit));
-      onzerostart = false;
-    }
-  }
-}
-
 __attribute__((weak))
 void unicodemap_input_error() {}
 
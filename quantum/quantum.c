@@ -59,6 +59,10 @@ extern backlight_config_t backlight_config;
 #include "encoder.h"
 #endif
 
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#include "dynamic_keymap.h"
+#endif
+
 #ifdef AUDIO_ENABLE
   #ifndef GOODBYE_SONG
     #define GOODBYE_SONG SONG(GOODBYE_SOUND)
@@ -189,6 +193,10 @@ void reset_keyboard(void) {
 #ifdef HAPTIC_ENABLE
   haptic_shutdown();
 #endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+  dynamic_keymap_flush();
+#endif
+  eeconfig_flush();
 // this is also done later in bootloader.c - not sure if it's neccesary here
 #ifdef BOOTLOADER_CATERINA
   *(uint16_t *)0x0800 = 0x7777; // these two are a-star-specific
@@ -225,94 +233,169 @@ static uint16_t scs_timer[2] = {0, 0};
  */
 static bool grave_esc_was_shifted = false;
 
-bool process_record_quantum(keyrecord_t *record) {
-
-  /* This gets the keycode from the key pressed */
-  keypos_t key = record->event.key;
-  uint16_t keycode;
-
-  #if !defined(NO_ACTION_LAYER) && !defined(STRICT_LAYER_RELEASE)
-    /* TODO: Use store_or_get_action() or a similar function. */
-    if (!disable_action_cache) {
-      uint8_t layer;
-
-      if (record->event.pressed) {
-        layer = layer_switch_get_layer(key);
-        update_source_layers_cache(key, layer);
-      } else {
-        layer = read_source_layers_cache(key);
-      }
-      keycode = keymap_key_to_keycode(layer, key);
-    } else
-  #endif
-    keycode = keymap_key_to_keycode(layer_switch_get_layer(key), key);
-
-    // This is how you use actions here
-    // if (keycode == KC_LEAD) {
-    //   action_t action;
-    //   action.code = ACTION_DEFAULT_LAYER_SET(0);
-    //   process_action(record, action);
-    //   return false;
-    // }
-
-  #ifdef VELOCIKEY_ENABLE
-    if (velocikey_enabled() && record->event.pressed) { velocikey_accelerate(); }
-  #endif
+/* A feature of the process_record_quantum() chain, that is only called for
+ * keycodes from first to last. Features that look at every key use ANY_KEYCODE.
+ */
+typedef struct {
+  bool (*process)(uint16_t keycode, keyrecord_t *record);
+  uint16_t first;
+  uint16_t last;
+#ifdef DEBUG_PROCESS_RECORD
+  const char *name;
+#endif
+} process_record_feature_t;
 
-  #ifdef TAP_DANCE_ENABLE
-    preprocess_tap_dance(keycode, record);
-  #endif
+#ifdef DEBUG_PROCESS_RECORD
+  #define PROCESS_RECORD_FEATURE_(process, first, last) { process, first, last, #process }
+#else
+  #define PROCESS_RECORD_FEATURE_(process, first, last) { process, first, last }
+#endif
+// Expands ANY_KEYCODE before it is split into first and last
+#define PROCESS_RECORD_FEATURE(...) PROCESS_RECORD_FEATURE_(__VA_ARGS__)
+#define ANY_KEYCODE 0x0000, 0xFFFF
 
-  if (!(
-  #if defined(KEY_LOCK_ENABLE)
-    // Must run first to be able to mask key_up events.
-    process_key_lock(&keycode, record) &&
-  #endif
+/* The order of the table is the order in which the features see a key */
+static const process_record_feature_t process_record_features[] = {
   #if defined(AUDIO_ENABLE) && defined(AUDIO_CLICKY)
-    process_clicky(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_clicky, ANY_KEYCODE),
   #endif //AUDIO_CLICKY
   #ifdef HAPTIC_ENABLE
-    process_haptic(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_haptic, ANY_KEYCODE),
   #endif //HAPTIC_ENABLE
   #if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_KEYREACTIVE_ENABLED)
-    process_rgb_matrix(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_rgb_matrix, ANY_KEYCODE),
   #endif
-    process_record_kb(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_record_kb, ANY_KEYCODE),
   #if defined(MIDI_ENABLE) && defined(MIDI_ADVANCED)
-    process_midi(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_midi, MIDI_TONE_MIN, MI_BENDU),
   #endif
   #ifdef AUDIO_ENABLE
-    process_audio(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_audio, AU_ON, MUV_DE),
   #endif
   #ifdef STENO_ENABLE
-    process_steno(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_steno, QK_STENO, QK_STENO_MAX),
   #endif
   #if (defined(AUDIO_ENABLE) || (defined(MIDI_ENABLE) && defined(MIDI_BASIC))) && !defined(NO_MUSIC_MODE)
-    process_music(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_music, ANY_KEYCODE),
   #endif
   #ifdef TAP_DANCE_ENABLE
-    process_tap_dance(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_tap_dance, ANY_KEYCODE),
   #endif
-  #if defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE) || defined(UCIS_ENABLE)
-    process_unicode_common(keycode, record) &&
+  #if defined(UCIS_ENABLE)
+    // UCIS reads every key while a sequence is typed
+    PROCESS_RECORD_FEATURE(process_unicode_common, ANY_KEYCODE),
+  #elif defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE)
+    PROCESS_RECORD_FEATURE(process_unicode_common, UNICODE_MODE_FORWARD, UNICODE_MODE_WINC),
+    // X() keycodes share the range of UC() keycodes
+    PROCESS_RECORD_FEATURE(process_unicode_common, QK_UNICODE, QK_UNICODE_MAX),
   #endif
   #ifdef LEADER_ENABLE
-    process_leader(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_leader, ANY_KEYCODE),
   #endif
   #ifdef COMBO_ENABLE
-    process_combo(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_combo, ANY_KEYCODE),
   #endif
   #ifdef PRINTING_ENABLE
-    process_printer(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_printer, ANY_KEYCODE),
   #endif
   #ifdef AUTO_SHIFT_ENABLE
-    process_auto_shift(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_auto_shift, ANY_KEYCODE),
   #endif
   #ifdef TERMINAL_ENABLE
-    process_terminal(keycode, record) &&
+    PROCESS_RECORD_FEATURE(process_terminal, ANY_KEYCODE),
+  #endif
+};
+
+#define PROCESS_RECORD_FEATURE_COUNT (sizeof(process_record_features) / sizeof(process_record_features[0]))
+
+#ifdef DEBUG_PROCESS_RECORD
+  #ifndef PROCESS_RECORD_CYCLE_COUNT
+    #if defined(PROTOCOL_CHIBIOS) && PORT_SUPPORTS_RT
+      #define PROCESS_RECORD_CYCLE_COUNT() ((uint32_t)chSysGetRealtimeCounterX())
+    #else
+      // Only counts milliseconds, define PROCESS_RECORD_CYCLE_COUNT() for something finer
+      #define PROCESS_RECORD_CYCLE_COUNT() timer_read32()
+    #endif
+  #endif
+
+static uint32_t process_record_calls[PROCESS_RECORD_FEATURE_COUNT];
+static uint32_t process_record_cycles[PROCESS_RECORD_FEATURE_COUNT];
+
+void print_process_record_stats(void) {
+  for (uint8_t i = 0; i < PROCESS_RECORD_FEATURE_COUNT; i++) {
+    xprintf("%s: %lu calls, %lu cycles\n", process_record_features[i].name,
+            process_record_calls[i], process_record_cycles[i]);
+  }
+}
+#endif
+
+/* The feature a resumed record has already been through, see process_record_resume() */
+static bool (*process_record_resume_after)(uint16_t keycode, keyrecord_t *record);
+
+void process_record_resume(keyrecord_t *record, bool (*feature)(uint16_t keycode, keyrecord_t *record)) {
+  process_record_resume_after = feature;
+  process_record(record);
+}
+
+bool process_record_quantum(keyrecord_t *record) {
+
+  /* The keycode of the key pressed has been resolved by process_record() */
+  uint16_t keycode = record->keycode;
+  uint8_t first_feature = 0;
+
+  if (process_record_resume_after) {
+    // The record was held back by a feature, it only goes through the features after it
+    while (first_feature < PROCESS_RECORD_FEATURE_COUNT
+        && process_record_features[first_feature].process != process_record_resume_after) {
+      first_feature++;
+    }
+    first_feature++;
+    process_record_resume_after = NULL;
+  }
+
+    // This is how you use actions here
+    // if (keycode == KC_LEAD) {
+    //   action_t action;
+    //   action.code = ACTION_DEFAULT_LAYER_SET(0);
+    //   process_action(record, action);
+    //   return false;
+    // }
+
+  if (first_feature == 0) {
+  #ifdef VELOCIKEY_ENABLE
+    if (velocikey_enabled() && record->event.pressed) { velocikey_accelerate(); }
+  #endif
+
+  #ifdef TAP_DANCE_ENABLE
+    preprocess_tap_dance(keycode, record);
+  #endif
+
+  #if defined(KEY_LOCK_ENABLE)
+    // Must run first to be able to mask key_up events.
+    if (!process_key_lock(&keycode, record)) {
+      return false;
+    }
+  #endif
+  }
+
+  for (uint8_t i = first_feature; i < PROCESS_RECORD_FEATURE_COUNT; i++) {
+    const process_record_feature_t *feature = &process_record_features[i];
+    if (keycode < feature->first || keycode > feature->last) {
+      continue;
+    }
+  #ifdef DEBUG_PROCESS_RECORD
+    uint32_t start = PROCESS_RECORD_CYCLE_COUNT();
+    bool processed = !feature->process(keycode, record);
+    process_record_cycles[i] += PROCESS_RECORD_CYCLE_COUNT() - start;
+    process_record_calls[i]++;
+    if (processed) {
+      return false;
+    }
+  #else
+    if (!feature->process(keycode, record)) {
+      return false;
+    }
   #endif
-      true)) {
-    return false;
   }
 
   // Shift / paren setup
@@ -819,23 +902,23 @@ bool process_record_quantum(keyrecord_t *record) {
 }
 
 __attribute__ ((weak))
-const bool ascii_to_shift_lut[0x80] PROGMEM = {
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 1, 1, 1, 1, 1, 1, 0,
-    1, 1, 1, 1, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 1, 0, 1, 0, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 0, 0, 0, 1, 1,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 1, 1, 1, 1, 0
+const uint8_t ascii_to_shift_lut[16] PROGMEM = {
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 1, 1, 1, 1, 1, 1, 0),
+    KCLUT_ENTRY(1, 1, 1, 1, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 1, 0, 1, 0, 1, 1),
+    KCLUT_ENTRY(1, 1, 1, 1, 1, 1, 1, 1),
+    KCLUT_ENTRY(1, 1, 1, 1, 1, 1, 1, 1),
+    KCLUT_ENTRY(1, 1, 1, 1, 1, 1, 1, 1),
+    KCLUT_ENTRY(1, 1, 1, 0, 0, 0, 1, 1),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 0, 0, 0, 0, 0),
+    KCLUT_ENTRY(0, 0, 0, 1, 1, 1, 1, 0)
 };
 
 __attribute__ ((weak))
@@ -858,78 +941,138 @@ const uint8_t ascii_to_keycode_lut[0x80] PROGMEM = {
     KC_X, KC_Y, KC_Z, KC_LBRC, KC_BSLS, KC_RBRC, KC_GRV, KC_DEL
 };
 
-void send_string(const char *str) {
-  send_string_with_delay(str, 0);
+/* send_string packs the characters it types into as few keyboard reports as
+ * possible. The keys of consecutive characters are pressed one per report and
+ * stay down until a key repeats, the shift state changes or the report is
+ * full, then they are all released with a single report. A report never adds
+ * more than one key press, so the host still sees the presses in the order of
+ * the string.
+ */
+static uint8_t send_string_keys[KEYBOARD_REPORT_KEYS];
+static uint8_t send_string_key_count = 0;
+static bool send_string_shifted = false;
+
+static void send_string_release_keys(void) {
+  for (uint8_t i = 0; i < send_string_key_count; i++) {
+    del_key(send_string_keys[i]);
+  }
+  send_string_key_count = 0;
 }
 
-void send_string_P(const char *str) {
-  send_string_with_delay_P(str, 0);
+static bool send_string_key_is_down(uint8_t keycode) {
+  for (uint8_t i = 0; i < send_string_key_count; i++) {
+    if (send_string_keys[i] == keycode) {
+      return true;
+    }
+  }
+  return false;
 }
 
-void send_string_with_delay(const char *str, uint8_t interval) {
-    while (1) {
-        char ascii_code = *str;
-        if (!ascii_code) break;
-        if (ascii_code == 1) {
-          // tap
-          uint8_t keycode = *(++str);
-          register_code(keycode);
-          unregister_code(keycode);
-        } else if (ascii_code == 2) {
-          // down
-          uint8_t keycode = *(++str);
-          register_code(keycode);
-        } else if (ascii_code == 3) {
-          // up
-          uint8_t keycode = *(++str);
-          unregister_code(keycode);
-        } else {
-          send_char(ascii_code);
-        }
-        ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
+void send_string_flush(void) {
+  if (!send_string_key_count && !send_string_shifted) {
+    return;
+  }
+  send_string_release_keys();
+  if (send_string_shifted) {
+    del_mods(MOD_BIT(KC_LSFT));
+    send_string_shifted = false;
+  }
+  send_keyboard_report();
+}
+
+static void send_string_key(uint8_t keycode, bool shifted) {
+  bool changed = false;
+  if (shifted != send_string_shifted
+      || send_string_key_count == KEYBOARD_REPORT_KEYS
+      || has_anykey(keyboard_report) >= KEYBOARD_REPORT_KEYS
+      || send_string_key_is_down(keycode)) {
+    changed = send_string_key_count;
+    send_string_release_keys();
+  }
+  if (shifted != send_string_shifted) {
+    // Releasing keys and changing the modifiers can share a report, a key press can't
+    if (shifted) {
+      add_mods(MOD_BIT(KC_LSFT));
+    } else {
+      del_mods(MOD_BIT(KC_LSFT));
     }
+    send_string_shifted = shifted;
+    changed = true;
+  }
+  if (changed) {
+    send_keyboard_report();
+  }
+
+  add_key(keycode);
+  send_string_keys[send_string_key_count++] = keycode;
+  send_keyboard_report();
 }
 
-void send_string_with_delay_P(const char *str, uint8_t interval) {
+static void send_string_char(char ascii_code) {
+  uint8_t keycode = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
+  bool shifted = pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code / 8]) & (1 << ((uint8_t)ascii_code % 8));
+  if (keycode != KC_NO) {
+    send_string_key(keycode, shifted);
+  }
+}
+
+/* Types a basic keycode the way send_string types a character, it may stay
+ * down until send_string_flush() or the next key that needs a new report.
+ */
+void send_string_tap_code(uint8_t keycode) {
+  send_string_key(keycode, false);
+}
+
+/* Strings in RAM and in PROGMEM share one decoder, reading a byte is the only
+ * difference between them.
+ */
+static void send_string_decode(const char *str, uint8_t interval, bool progmem) {
     while (1) {
-        char ascii_code = pgm_read_byte(str);
+        char ascii_code = progmem ? pgm_read_byte(str) : *str;
         if (!ascii_code) break;
-        if (ascii_code == 1) {
-          // tap
-          uint8_t keycode = pgm_read_byte(++str);
-          register_code(keycode);
-          unregister_code(keycode);
-        } else if (ascii_code == 2) {
-          // down
-          uint8_t keycode = pgm_read_byte(++str);
-          register_code(keycode);
-        } else if (ascii_code == 3) {
-          // up
-          uint8_t keycode = pgm_read_byte(++str);
-          unregister_code(keycode);
+        if (ascii_code >= 1 && ascii_code <= 3) {
+          uint8_t keycode = progmem ? pgm_read_byte(++str) : *(++str);
+          send_string_flush();
+          if (ascii_code != 3) {
+            // tap or down
+            register_code(keycode);
+          }
+          if (ascii_code != 2) {
+            // tap or up
+            unregister_code(keycode);
+          }
         } else {
-          send_char(ascii_code);
+          send_string_char(ascii_code);
         }
         ++str;
-        // interval
-        { uint8_t ms = interval; while (ms--) wait_ms(1); }
+        // interval, every character is typed on its own then
+        if (interval) {
+          send_string_flush();
+          uint8_t ms = interval; while (ms--) wait_ms(1);
+        }
     }
+    send_string_flush();
+}
+
+void send_string(const char *str) {
+  send_string_decode(str, 0, false);
+}
+
+void send_string_P(const char *str) {
+  send_string_decode(str, 0, true);
+}
+
+void send_string_with_delay(const char *str, uint8_t interval) {
+  send_string_decode(str, interval, false);
+}
+
+void send_string_with_delay_P(const char *str, uint8_t interval) {
+  send_string_decode(str, interval, true);
 }
 
 void send_char(char ascii_code) {
-  uint8_t keycode;
-  keycode = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
-  if (pgm_read_byte(&ascii_to_shift_lut[(uint8_t)ascii_code])) {
-      register_code(KC_LSFT);
-      register_code(keycode);
-      unregister_code(keycode);
-      unregister_code(KC_LSFT);
-  } else {
-      register_code(keycode);
-      unregister_code(keycode);
-  }
+  send_string_char(ascii_code);
+  send_string_flush();
 }
 
 void set_single_persistent_default_layer(uint8_t default_layer) {
@@ -1046,6 +1189,12 @@ void matrix_init_quantum() {
   #ifdef HAPTIC_ENABLE
     haptic_init();
   #endif
+  #ifdef COMBO_ENABLE
+    combo_init();
+  #endif
+  #ifdef LEADER_ENABLE
+    leader_init();
+  #endif
   matrix_init_kb();
 }
 
@@ -1054,14 +1203,6 @@ void matrix_scan_quantum() {
     matrix_scan_music();
   #endif
 
-  #ifdef TAP_DANCE_ENABLE
-    matrix_scan_tap_dance();
-  #endif
-
-  #ifdef COMBO_ENABLE
-    matrix_scan_combo();
-  #endif
-
   #if defined(BACKLIGHT_ENABLE)
     #if defined(LED_MATRIX_ENABLE)
         led_matrix_task();
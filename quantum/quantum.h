@@ -49,6 +49,7 @@
 #endif
 
 #include "action_layer.h"
+#include "action_tapping.h"
 #include "eeconfig.h"
 #include <stddef.h>
 #include "bootloader.h"
@@ -201,13 +202,26 @@ extern uint32_t default_layer_state;
 #define SS_ALGR(string) SS_RALT(string)
 
 #define SEND_STRING(str) send_string_P(PSTR(str))
-extern const bool ascii_to_shift_lut[0x80];
+// Packs eight booleans of the ascii_to_shift_lut into one byte, the first one in bit 0
+#define KCLUT_ENTRY(a, b, c, d, e, f, g, h) \
+    ( ((a) ? 1 : 0) << 0 \
+    | ((b) ? 1 : 0) << 1 \
+    | ((c) ? 1 : 0) << 2 \
+    | ((d) ? 1 : 0) << 3 \
+    | ((e) ? 1 : 0) << 4 \
+    | ((f) ? 1 : 0) << 5 \
+    | ((g) ? 1 : 0) << 6 \
+    | ((h) ? 1 : 0) << 7 )
+
+extern const uint8_t ascii_to_shift_lut[16];
 extern const uint8_t ascii_to_keycode_lut[0x80];
 void send_string(const char *str);
 void send_string_with_delay(const char *str, uint8_t interval);
 void send_string_P(const char *str);
 void send_string_with_delay_P(const char *str, uint8_t interval);
 void send_char(char ascii_code);
+void send_string_tap_code(uint8_t keycode);
+void send_string_flush(void);
 
 // For tri-layer
 void update_tri_layer(uint8_t layer1, uint8_t layer2, uint8_t layer3);
@@ -227,6 +241,11 @@ void matrix_scan_user(void);
 bool process_action_kb(keyrecord_t *record);
 bool process_record_kb(uint16_t keycode, keyrecord_t *record);
 bool process_record_user(uint16_t keycode, keyrecord_t *record);
+// Processes a record held back by feature, starting with the features after it
+void process_record_resume(keyrecord_t *record, bool (*feature)(uint16_t keycode, keyrecord_t *record));
+#ifdef DEBUG_PROCESS_RECORD
+void print_process_record_stats(void);
+#endif
 
 #ifndef BOOTMAGIC_LITE_COLUMN
   #define BOOTMAGIC_LITE_COLUMN 0
@@ -91,11 +91,11 @@ static uint32_t rgb_counters_buffer;
 #endif // RGB_MATRIX_KEYREACTIVE_ENABLED
 
 uint32_t eeconfig_read_rgb_matrix(void) {
-  return eeprom_read_dword(EECONFIG_RGB_MATRIX);
+  return eeconfig_read_dword(EECONFIG_RGB_MATRIX);
 }
 
 void eeconfig_update_rgb_matrix(uint32_t val) {
-  eeprom_update_dword(EECONFIG_RGB_MATRIX, val);
+  eeconfig_update_dword(EECONFIG_RGB_MATRIX, val);
 }
 
 void eeconfig_update_rgb_matrix_default(void) {
@@ -24,7 +24,7 @@ bool is_keyboard_left(void) {
     setPinInput(SPLIT_HAND_PIN);
     return readPin(SPLIT_HAND_PIN);
   #elif defined(EE_HANDS)
-    return eeprom_read_byte(EECONFIG_HANDEDNESS);
+    return eeconfig_read_byte(EECONFIG_HANDEDNESS);
   #elif defined(MASTER_RIGHT)
     return !is_keyboard_master();
   #endif
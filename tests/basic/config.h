@@ -20,4 +20,8 @@
 #define MATRIX_ROWS 4
 #define MATRIX_COLS 10
 
+#define TAPPING_TERM_PER_KEY
+
+#define ONESHOT_TIMEOUT 500
+
 #endif /* TESTS_BASIC_CONFIG_H_ */
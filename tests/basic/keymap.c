@@ -25,12 +25,17 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
     [0] = {
         // 0    1      2      3        4        5        6       7            8      9
         {KC_A,  KC_B,  KC_NO, KC_LSFT, KC_RSFT, KC_LCTL, COMBO1, SFT_T(KC_P), M(0),  KC_NO},
-        {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
-        {KC_NO, KC_NO, KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
+        {CTL_T(KC_E), ALT_T(KC_F), GUI_T(KC_G), SFT_T(KC_H), KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+        {OSM(MOD_LSFT), KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO,  KC_NO, KC_NO},
         {KC_C,  KC_D,  KC_NO, KC_NO,   KC_NO,   KC_NO,   KC_NO,  KC_NO,       KC_NO, KC_NO},
     },
 };
 
+// Every tap key on row 1 has its own tapping setting
+const uint16_t PROGMEM tapping_terms[MATRIX_ROWS][MATRIX_COLS] = {
+    [1] = {100, TAPPING_HOLD_ON_OTHER_KEY_PRESS, TAPPING_PERMISSIVE_HOLD, TAPPING_RETRO},
+};
+
 const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt) {
     if (record->event.pressed) {
         switch(id) {
@@ -18,6 +18,7 @@
 
 using testing::_;
 using testing::Return;
+using testing::InSequence;
 
 class KeyPress : public TestFixture {};
 
@@ -39,19 +40,18 @@ TEST_F(KeyPress, CorrectKeyIsReportedWhenPressed) {
 
 TEST_F(KeyPress, CorrectKeysAreReportedWhenTwoKeysArePressed) {
     TestDriver driver;
+    InSequence s;
     press_key(1, 0);
     press_key(0, 3);
-    //Note that QMK only processes one key at a time
-    //See issue #1476 for more information
+    //Note that all keys changed in a scan are processed by the same task call
+    //Each of them still produces its own report
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
     keyboard_task();
     release_key(1, 0);
     release_key(0, 3);
     //Note that the first key released is the first one in the matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
     keyboard_task();
 }
@@ -66,12 +66,11 @@ TEST_F(KeyPress, ANonMappedKeyDoesNothing) {
 
 TEST_F(KeyPress, LeftShiftIsReportedCorrectly) {
     TestDriver driver;
+    InSequence s;
     press_key(3, 0);
     press_key(0, 0);
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
+    // Both keys change in the same scan, they are processed in matrix order
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_LSFT)));
     keyboard_task();
     release_key(0, 0);
@@ -84,24 +83,20 @@ TEST_F(KeyPress, LeftShiftIsReportedCorrectly) {
 
 TEST_F(KeyPress, PressLeftShiftAndControl) {
     TestDriver driver;
+    InSequence s;
     press_key(3, 0);
     press_key(5, 0);
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_LCTRL)));
     keyboard_task();
 }
 
 TEST_F(KeyPress, LeftAndRightShiftCanBePressedAtTheSameTime) {
     TestDriver driver;
+    InSequence s;
     press_key(3, 0);
     press_key(4, 0);
-    // Unfortunately modifiers are also processed in the wrong order
-    // See issue #1476 for more information
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
-    keyboard_task();
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_RSFT)));
     keyboard_task();
 }
@@ -0,0 +1,66 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "action_util.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class OneShot : public TestFixture {
+protected:
+    void tap_oneshot_shift() {
+        press_key(0, 2);
+        run_one_scan_loop();
+        release_key(0, 2);
+        run_one_scan_loop();
+    }
+};
+
+TEST_F(OneShot, ModIsAppliedToTheNextKey) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_oneshot_shift();
+    idle_for(ONESHOT_TIMEOUT - 10);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(OneShot, ModTimesOutWhileIdle) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    tap_oneshot_shift();
+    idle_for(ONESHOT_TIMEOUT - 10);
+    EXPECT_EQ(MOD_BIT(KC_LSFT), get_oneshot_mods());
+    // Cleared on time, without waiting for the next report
+    idle_for(10);
+    EXPECT_EQ(0, get_oneshot_mods());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A))).Times(0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+}
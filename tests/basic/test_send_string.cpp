@@ -0,0 +1,125 @@
+/* Copyright 2017 Fred Sundvik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class SendString : public TestFixture {};
+
+TEST_F(SendString, KeysArePressedOnePerReportAndReleasedTogether) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("abc");
+}
+
+TEST_F(SendString, RepeatedKeyIsReleasedFirst) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_E, KC_L)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_L)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_L, KC_O)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("ello");
+}
+
+TEST_F(SendString, ShiftedRunsShareOneShiftPress) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    // The released key and the shift press share a report
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_Q)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_Q, KC_M)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_Q, KC_M, KC_K)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_SPC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("aQMK ");
+}
+
+TEST_F(SendString, FullReportIsReleased) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_C, KC_D, KC_E, KC_F)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_G)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("abcdefg");
+}
+
+TEST_F(SendString, TapCodesAreTypedInOrder) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_V)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_V, KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_HOME)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_L)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_L, KC_O)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("ve" SS_TAP(X_HOME) "lo");
+}
+
+TEST_F(SendString, HeldModifiersStayDown) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL, KC_A, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string(SS_LCTRL("ac"));
+}
+
+TEST_F(SendString, IntervalTypesEveryCharacterOnItsOwn) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string_with_delay("aB", 10);
+}
+
+TEST_F(SendString, ShiftedSymbolsUseTheShiftTable) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_1)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_1, KC_GRV)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_GRV)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_GRV, KC_SLSH)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_SLSH)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("!~`/?");
+}
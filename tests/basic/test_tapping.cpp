@@ -15,9 +15,12 @@
  */
 
 #include "test_common.hpp"
+extern "C" {
 #include "action_tapping.h"
+}
 
 using testing::_;
+using testing::AnyNumber;
 using testing::InSequence;
 
 class Tapping : public TestFixture {};
@@ -95,3 +98,155 @@ TEST_F(Tapping, ANewTapWithinTappingTermIsBuggy) {
     EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT))).Times(1);
     idle_for(TAPPING_TERM);
 }
+
+TEST_F(Tapping, KeysThatDontFitIntoTheWaitingBufferWaitInTheMatrix) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    // Eight events fill the waiting buffer while the tapping key is undecided
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+    press_key(0, 3);
+    run_one_scan_loop();
+    press_key(1, 3);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    run_one_scan_loop();
+    release_key(0, 3);
+    run_one_scan_loop();
+    release_key(1, 3);
+    run_one_scan_loop();
+    EXPECT_EQ(0, waiting_buffer_free());
+    // This one is not read until the buffer has drained
+    press_key(5, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A, KC_B, KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A, KC_B, KC_C, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_B, KC_C, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_C, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_D)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_LCTL)));
+    idle_for(TAPPING_TERM);
+    EXPECT_EQ(WAITING_BUFFER_SIZE, waiting_buffer_high_water());
+    EXPECT_EQ(0, waiting_buffer_overflows());
+}
+
+TEST_F(Tapping, PerKeyTappingTermIsUsed) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(99);
+    // Scan times are odd, so the hold can be one scan late
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LCTL)));
+    idle_for(2);
+    release_key(0, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Tapping, HoldOnOtherKeyPressSettlesRightAway) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT, KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LALT)));
+    run_one_scan_loop();
+    release_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Tapping, HoldOnOtherKeyPressStillTaps) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(1, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Tapping, PermissiveHoldSettlesWhenAKeyIsTyped) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(2, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LGUI)));
+    run_one_scan_loop();
+    release_key(2, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Tapping, PermissiveHoldIsOnlyUsedForItsKey) {
+    TestDriver driver;
+
+    // The same as above, but nothing is decided until the tapping key is released
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(7, 0);
+    // The interrupted tap still turns into a hold
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // But the typed key waits for the rest of the tapping term
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    idle_for(TAPPING_TERM);
+}
+
+TEST_F(Tapping, RetroTappingTapsAfterTheTerm) {
+    TestDriver driver;
+    InSequence s;
+
+    press_key(3, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(TAPPING_TERM - 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    idle_for(2);
+    release_key(3, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_H)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
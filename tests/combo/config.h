@@ -0,0 +1,29 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_COMBO_CONFIG_H_
+#define TESTS_COMBO_CONFIG_H_
+
+#define MATRIX_ROWS 4
+#define MATRIX_COLS 10
+
+#define COMBO_COUNT 7
+// Too small for all combos, the last ones are scanned linearly
+#define COMBO_INDEX_SIZE 6
+// Room for the nine key combo
+#define COMBO_KEY_BUFFER_LENGTH 10
+
+#endif /* TESTS_COMBO_CONFIG_H_ */
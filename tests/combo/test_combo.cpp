@@ -0,0 +1,233 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+namespace {
+std::vector<std::pair<uint16_t, bool>> combo_events;
+}
+
+extern "C" void process_combo_event(uint16_t combo_index, bool pressed) {
+    combo_events.push_back(std::make_pair(combo_index, pressed));
+}
+
+class Combo : public TestFixture {
+public:
+    Combo() {
+        combo_events.clear();
+    }
+};
+
+TEST_F(Combo, IndexedComboIsSent) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    press_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_TAB)));
+    run_one_scan_loop();
+    // The combo is released with its first key, the other releases are swallowed
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    release_key(3, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ScannedComboIsSent) {
+    TestDriver driver;
+    InSequence s;
+    press_key(4, 0);
+    press_key(5, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(6, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENT)));
+    run_one_scan_loop();
+    release_key(4, 0);
+    release_key(5, 0);
+    release_key(6, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ComboActionIsCalledWithItsIndex) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(7, 0);
+    press_key(8, 0);
+    run_one_scan_loop();
+    release_key(7, 0);
+    release_key(8, 0);
+    run_one_scan_loop();
+    ASSERT_EQ(2u, combo_events.size());
+    EXPECT_EQ(std::make_pair((uint16_t)3, true), combo_events[0]);
+    EXPECT_EQ(std::make_pair((uint16_t)3, false), combo_events[1]);
+}
+
+TEST_F(Combo, ComboWithMoreThanEightKeysIsSent) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    for (uint8_t col = 0; col < 8; col++) {
+        press_key(col, 1);
+    }
+    run_one_scan_loop();
+    press_key(8, 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F1)));
+    run_one_scan_loop();
+    for (uint8_t col = 0; col < 9; col++) {
+        release_key(col, 1);
+    }
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, LongestOverlappingComboIsSent) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_DEL)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(1, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ShorterOverlappingComboIsSentAfterComboTerm) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    press_key(1, 0);
+    // Waits for the longer combo
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ShorterOverlappingComboIsSentWhenAKeyIsReleased) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, TappedComboKeyIsSentOnceOnRelease) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, HeldComboKeyIsSentAfterComboTerm) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, UnmatchedKeysAreReplayedInOrder) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM - 1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_E)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    release_key(4, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ReplayedQuantumKeyIsPressedAndReleased) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(COMBO_TERM);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ESC)));
+    run_one_scan_loop();
+    release_key(1, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, OtherKeyReplaysBufferedKeysFirst) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    run_one_scan_loop();
+    press_key(9, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C, KC_K)));
+    run_one_scan_loop();
+    release_key(2, 0);
+    release_key(9, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_K)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, OtherKeysAreNotAffected) {
+    TestDriver driver;
+    InSequence s;
+    press_key(9, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_K)));
+    run_one_scan_loop();
+    release_key(9, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
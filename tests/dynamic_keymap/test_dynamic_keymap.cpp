@@ -0,0 +1,130 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "tmk_core/common/eeprom.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+using testing::InSequence;
+
+namespace {
+
+uint16_t eeprom_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+    uint8_t *address = (uint8_t *)dynamic_keymap_key_to_eeprom_address(layer, row, column);
+    return eeprom_read_byte(address) << 8 | eeprom_read_byte(address + 1);
+}
+
+}
+
+class DynamicKeymap : public TestFixture {
+public:
+    DynamicKeymap() {
+        dynamic_keymap_reset();
+        dynamic_keymap_flush();
+    }
+
+    TestDriver driver;
+};
+
+TEST_F(DynamicKeymap, ChangedKeyIsUsedRightAway) {
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    press_key(0, 0);
+    run_one_scan_loop();
+    release_key(0, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(DynamicKeymap, ChangesAreWrittenAfterTheDelay) {
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    dynamic_keymap_set_keycode(0, 0, 1, KC_Z);
+    EXPECT_EQ(KC_Z, dynamic_keymap_get_keycode(0, 0, 1));
+    EXPECT_EQ(KC_B, eeprom_keycode(0, 0, 1));
+
+    idle_for(DYNAMIC_KEYMAP_WRITE_DELAY - 1);
+    EXPECT_EQ(KC_B, eeprom_keycode(0, 0, 1));
+    idle_for(2);
+    EXPECT_EQ(KC_Z, eeprom_keycode(0, 0, 1));
+}
+
+TEST_F(DynamicKeymap, ChangesInQuickSuccessionAreWrittenTogether) {
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    dynamic_keymap_set_keycode(1, 0, 0, KC_X);
+    idle_for(DYNAMIC_KEYMAP_WRITE_DELAY / 2);
+    dynamic_keymap_set_keycode(1, 1, 0, KC_Y);
+    idle_for(DYNAMIC_KEYMAP_WRITE_DELAY / 2 + 2);
+    // The second change postponed the write of the first one
+    EXPECT_EQ(KC_1, eeprom_keycode(1, 0, 0));
+    EXPECT_EQ(KC_3, eeprom_keycode(1, 1, 0));
+
+    idle_for(DYNAMIC_KEYMAP_WRITE_DELAY / 2);
+    EXPECT_EQ(KC_X, eeprom_keycode(1, 0, 0));
+    EXPECT_EQ(KC_Y, eeprom_keycode(1, 1, 0));
+}
+
+TEST_F(DynamicKeymap, FlushWritesRightAway) {
+    dynamic_keymap_set_keycode(0, 1, 0, KC_Z);
+    dynamic_keymap_flush();
+    EXPECT_EQ(KC_Z, eeprom_keycode(0, 1, 0));
+}
+
+TEST_F(DynamicKeymap, BufferIncludesPendingChanges) {
+    dynamic_keymap_set_keycode(0, 0, 1, 0x1234);
+
+    uint8_t data[4];
+    dynamic_keymap_get_buffer(2, sizeof(data), data);
+    EXPECT_EQ(0x12, data[0]);
+    EXPECT_EQ(0x34, data[1]);
+    EXPECT_EQ(0x00, data[2]);
+    EXPECT_EQ(KC_C, data[3]);
+}
+
+TEST_F(DynamicKeymap, SetBufferUpdatesTheKeymap) {
+    // Starts in the middle of a keycode and runs past the end of the keymap
+    uint8_t data[] = {KC_Y, 0x00, KC_Z, 0xAA, 0xBB};
+    dynamic_keymap_set_buffer(DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2 - 3, sizeof(data), data);
+    EXPECT_EQ(KC_Y, dynamic_keymap_get_keycode(1, 1, 0));
+    EXPECT_EQ(KC_Z, dynamic_keymap_get_keycode(1, 1, 1));
+
+    dynamic_keymap_flush();
+    EXPECT_EQ(KC_Y, eeprom_keycode(1, 1, 0));
+    EXPECT_EQ(KC_Z, eeprom_keycode(1, 1, 1));
+}
+
+TEST_F(DynamicKeymap, MacroBufferIsTransferredAsBlocks) {
+    dynamic_keymap_macro_reset();
+    // Runs past the end of the macro buffer, the rest reads back as zeros
+    uint8_t data[] = {'a', 'b', 'c', 'd', 'e', 'f'};
+    dynamic_keymap_macro_set_buffer(DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 4, sizeof(data), data);
+    EXPECT_EQ('a', eeprom_read_byte((uint8_t *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 4));
+    EXPECT_EQ('d', eeprom_read_byte((uint8_t *)DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1));
+
+    uint8_t read[8];
+    memset(read, 0xAA, sizeof(read));
+    dynamic_keymap_macro_get_buffer(DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 5, sizeof(read), read);
+    uint8_t expected[] = {0x00, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x00};
+    for (unsigned i = 0; i < sizeof(read); i++) {
+        EXPECT_EQ(expected[i], read[i]) << "byte " << i;
+    }
+}
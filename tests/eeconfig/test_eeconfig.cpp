@@ -0,0 +1,107 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "eeconfig.h"
+#include "tmk_core/common/eeprom.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+// Past the end of the eeconfig block, not cached
+#define OUTSIDE_BLOCK ((uint8_t *)EECONFIG_SIZE + 4)
+
+class Eeconfig : public TestFixture {
+public:
+    Eeconfig() {
+        EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+        eeconfig_init();
+        eeprom_update_byte(OUTSIDE_BLOCK, 0);
+        requested = eeconfig_bytes_requested();
+        written = eeconfig_bytes_written();
+    }
+
+    uint32_t requested_since_start() { return eeconfig_bytes_requested() - requested; }
+    uint32_t written_since_start() { return eeconfig_bytes_written() - written; }
+
+    TestDriver driver;
+    uint32_t requested;
+    uint32_t written;
+};
+
+TEST_F(Eeconfig, ChangeIsReadBackRightAway) {
+    eeconfig_update_keymap(0x42);
+    EXPECT_EQ(0x42, eeconfig_read_keymap());
+    EXPECT_EQ(0x00, eeprom_read_byte(EECONFIG_KEYMAP));
+}
+
+TEST_F(Eeconfig, ChangeIsWrittenAfterTheDelay) {
+    eeconfig_update_kb(0x12345678);
+    idle_for(EECONFIG_WRITE_DELAY - 1);
+    EXPECT_EQ(0u, eeprom_read_dword(EECONFIG_KEYBOARD));
+    idle_for(2);
+    EXPECT_EQ(0x12345678u, eeprom_read_dword(EECONFIG_KEYBOARD));
+    EXPECT_EQ(4u, written_since_start());
+}
+
+TEST_F(Eeconfig, BurstOfChangesIsWrittenOnce) {
+    // Like holding a key that steps through the brightness
+    for (uint8_t step = 1; step <= 50; step++) {
+        eeconfig_update_user(step);
+        idle_for(EECONFIG_WRITE_DELAY / 10);
+    }
+    EXPECT_EQ(0u, eeprom_read_dword(EECONFIG_USER));
+    idle_for(EECONFIG_WRITE_DELAY);
+    EXPECT_EQ(50u, eeprom_read_dword(EECONFIG_USER));
+    EXPECT_EQ(50u * 4, requested_since_start());
+    EXPECT_EQ(1u, written_since_start());
+}
+
+TEST_F(Eeconfig, UnchangedValueIsNotWritten) {
+    eeconfig_update_keymap(0x42);
+    eeconfig_update_keymap(0x00);
+    idle_for(EECONFIG_WRITE_DELAY + 1);
+    EXPECT_EQ(2u, requested_since_start());
+    EXPECT_EQ(0u, written_since_start());
+}
+
+TEST_F(Eeconfig, FlushWritesRightAway) {
+    eeconfig_update_debug(0x05);
+    eeconfig_update_kb(0xAABBCCDD);
+    eeconfig_flush();
+    EXPECT_EQ(0x05, eeprom_read_byte(EECONFIG_DEBUG));
+    EXPECT_EQ(0xAABBCCDDu, eeprom_read_dword(EECONFIG_KEYBOARD));
+    EXPECT_EQ(5u, written_since_start());
+}
+
+TEST_F(Eeconfig, InitDropsPendingChanges) {
+    eeconfig_update_keymap(0x42);
+    eeconfig_init();
+    idle_for(EECONFIG_WRITE_DELAY + 1);
+    EXPECT_EQ(0x00, eeconfig_read_keymap());
+    EXPECT_EQ(0x00, eeprom_read_byte(EECONFIG_KEYMAP));
+    EXPECT_TRUE(eeconfig_is_enabled());
+}
+
+TEST_F(Eeconfig, AddressOutsideTheBlockIsWrittenRightAway) {
+    eeconfig_update_byte(OUTSIDE_BLOCK, 0x42);
+    EXPECT_EQ(0x42, eeprom_read_byte(OUTSIDE_BLOCK));
+    EXPECT_EQ(0x42, eeconfig_read_byte(OUTSIDE_BLOCK));
+    EXPECT_EQ(1u, written_since_start());
+}
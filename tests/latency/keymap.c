@@ -0,0 +1,42 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+// The benchmark scripts look keys up by keycode on layer 0, so every
+// keycode used by a script has to be unique on that layer.
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        // 0           1              2      3              4        5      6      7        8       9
+        {KC_Q,         KC_W,          KC_E,  KC_R,          KC_T,    KC_Y,  KC_U,  KC_I,    KC_O,   KC_P},
+        {KC_A,         KC_S,          KC_D,  KC_F,          KC_G,    KC_H,  KC_J,  KC_K,    KC_L,   KC_SCLN},
+        {KC_Z,         KC_X,          KC_C,  KC_V,          KC_B,    KC_N,  KC_M,  KC_COMM, KC_DOT, KC_SLSH},
+        {SFT_T(KC_ESC), CTL_T(KC_TAB), MO(1), LT(2, KC_SPC), KC_LSFT, KC_NO, KC_NO, KC_NO,   KC_NO,  KC_NO},
+    },
+    [1] = {
+        {KC_1,    KC_2,    KC_3,    KC_4,    KC_5,    KC_6,    KC_7,    KC_8,    KC_9,    KC_0},
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+    },
+    [2] = {
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+        {_______, _______, _______, _______, _______, KC_LEFT, KC_DOWN, KC_UP,   KC_RGHT, _______},
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+        {_______, _______, _______, _______, _______, _______, _______, _______, _______, _______},
+    },
+};
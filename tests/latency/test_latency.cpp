@@ -0,0 +1,264 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Scan-to-report latency benchmark
+ *
+ * Every script step changes the matrix through press_key/release_key and then
+ * runs keyboard_task() until the expected number of keyboard reports reached
+ * the TestDriver. For each step the number of keyboard_task() iterations and
+ * the host wall-clock time until that report are recorded, and a latency
+ * distribution per feature is printed when the suite finishes.
+ *
+ * The scan counts are deterministic, so they are also checked against upper
+ * bounds to catch regressions. Wall-clock numbers are informational only.
+ */
+
+#include "test_common.hpp"
+#include "action_tapping.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+namespace {
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Number of times every script is replayed
+const unsigned REPETITIONS = 50;
+// Give up on a step after this many scans
+const unsigned MAX_SCANS = 1000;
+
+struct KeyEdge {
+    uint16_t keycode;
+    bool pressed;
+};
+
+KeyEdge down(uint16_t keycode) { return KeyEdge{keycode, true}; }
+KeyEdge up(uint16_t keycode) { return KeyEdge{keycode, false}; }
+
+struct LatencySample {
+    unsigned scans;
+    bench_clock::duration wall;
+};
+
+keypos_t find_key(uint16_t keycode) {
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
+            keypos_t key = { .col = c, .row = r };
+            if (keymap_key_to_keycode(0, key) == keycode) {
+                return key;
+            }
+        }
+    }
+    ADD_FAILURE() << "Keycode " << keycode << " is not on layer 0";
+    return keypos_t{ .col = 0, .row = 0 };
+}
+
+template <typename T>
+T percentile(const std::vector<T>& sorted, unsigned p) {
+    return sorted[(sorted.size() - 1) * p / 100];
+}
+
+}
+
+class Latency : public TestFixture {
+public:
+    Latency() {
+        EXPECT_CALL(driver, send_keyboard_mock(_))
+            .Times(AnyNumber())
+            .WillRepeatedly(Invoke(this, &Latency::on_report));
+    }
+
+    static void TearDownTestCase();
+
+protected:
+    // Applies all edges within the same scan, then scans until `reports` keyboard reports were sent
+    LatencySample measure(std::initializer_list<KeyEdge> edges, unsigned reports = 1) {
+        for (auto& edge : edges) {
+            keypos_t key = find_key(edge.keycode);
+            if (edge.pressed) {
+                press_key(key.col, key.row);
+            } else {
+                release_key(key.col, key.row);
+            }
+        }
+        m_reports = 0;
+        m_reports_wanted = reports;
+        m_start = bench_clock::now();
+        m_end = m_start;
+        unsigned scans = 0;
+        while (m_reports < m_reports_wanted && scans < MAX_SCANS) {
+            run_one_scan_loop();
+            scans++;
+        }
+        EXPECT_LT(scans, MAX_SCANS) << "Timed out waiting for " << reports << " report(s)";
+        return LatencySample{scans, m_end - m_start};
+    }
+
+    // Measures a step and files the sample under `feature`
+    void record(const char* feature, std::initializer_list<KeyEdge> edges, unsigned reports = 1) {
+        results[feature].push_back(measure(edges, reports));
+    }
+
+    // Lets all pending timeouts expire so that the next repetition starts from scratch
+    void settle() {
+        idle_for(TAPPING_TERM + 10);
+    }
+
+    unsigned worst_scans(const char* feature) {
+        unsigned worst = 0;
+        for (auto& sample : results[feature]) {
+            worst = std::max(worst, sample.scans);
+        }
+        return worst;
+    }
+
+    TestDriver driver;
+    report_keyboard_t last_report;
+
+private:
+    void on_report(report_keyboard_t& report) {
+        last_report = report;
+        if (++m_reports == m_reports_wanted) {
+            m_end = bench_clock::now();
+        }
+    }
+
+    unsigned m_reports = 0;
+    unsigned m_reports_wanted = 0;
+    bench_clock::time_point m_start;
+    bench_clock::time_point m_end;
+
+    static std::map<std::string, std::vector<LatencySample>> results;
+};
+
+std::map<std::string, std::vector<LatencySample>> Latency::results;
+
+void Latency::TearDownTestCase() {
+    printf("\n%-22s %7s %24s %30s\n", "feature", "samples", "scans min/p50/p95/max", "wall us p50/p95/max");
+    for (auto& entry : results) {
+        std::vector<unsigned> scans;
+        std::vector<double> wall;
+        for (auto& sample : entry.second) {
+            scans.push_back(sample.scans);
+            wall.push_back(std::chrono::duration<double, std::micro>(sample.wall).count());
+        }
+        std::sort(scans.begin(), scans.end());
+        std::sort(wall.begin(), wall.end());
+        printf("%-22s %7u %9u/%4u/%4u/%4u %14.2f/%7.2f/%7.2f\n",
+            entry.first.c_str(), (unsigned)scans.size(),
+            scans.front(), percentile(scans, 50), percentile(scans, 95), scans.back(),
+            percentile(wall, 50), percentile(wall, 95), wall.back());
+    }
+    printf("\n");
+}
+
+TEST_F(Latency, TypingRollover) {
+    // Each key goes down before the previous one is released
+    const uint16_t text[] = {KC_T, KC_H, KC_E, KC_Q, KC_U, KC_I, KC_C, KC_K, KC_B, KC_R, KC_O, KC_W, KC_N};
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        uint16_t previous = KC_NO;
+        for (auto keycode : text) {
+            record("typing_rollover", {down(keycode)});
+            if (previous != KC_NO) {
+                record("typing_rollover", {up(previous)});
+            }
+            previous = keycode;
+        }
+        record("typing_rollover", {up(previous)});
+        settle();
+    }
+    EXPECT_LE(worst_scans("typing_rollover"), 1u);
+}
+
+TEST_F(Latency, TypingBurst) {
+    // Several keys change within the same scan, every edge produces its own report
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        record("typing_burst", {down(KC_A), down(KC_S), down(KC_D)}, 3);
+        record("typing_burst", {up(KC_A), up(KC_S), up(KC_D)}, 3);
+        record("typing_burst", {down(KC_P), down(KC_Z), down(KC_L), down(KC_M)}, 4);
+        record("typing_burst", {up(KC_P), up(KC_Z), up(KC_L), up(KC_M)}, 4);
+        settle();
+    }
+    // All matrix changes of a scan are handled by the same keyboard_task() call
+    EXPECT_LE(worst_scans("typing_burst"), 1u);
+}
+
+TEST_F(Latency, ModTapTap) {
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        // Nothing is reported until the key is released
+        measure({down(SFT_T(KC_ESC))}, 0);
+        run_one_scan_loop();
+        record("mod_tap_tap", {up(SFT_T(KC_ESC))});
+        settle();
+    }
+    EXPECT_LE(worst_scans("mod_tap_tap"), 1u);
+}
+
+TEST_F(Latency, ModTapHold) {
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        record("mod_tap_hold", {down(CTL_T(KC_TAB))});
+        measure({up(CTL_T(KC_TAB))});
+        settle();
+    }
+    EXPECT_LE(worst_scans("mod_tap_hold"), TAPPING_TERM + 1u);
+}
+
+TEST_F(Latency, ModTapChord) {
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        measure({down(SFT_T(KC_ESC))}, 0);
+        run_one_scan_loop();
+        // The other key is held back until the mod-tap key is settled
+        record("mod_tap_chord", {down(KC_J)});
+        measure({up(KC_J)});
+        measure({up(SFT_T(KC_ESC))});
+        settle();
+    }
+    EXPECT_LE(worst_scans("mod_tap_chord"), TAPPING_TERM + 1u);
+}
+
+TEST_F(Latency, MomentaryLayer) {
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        record("layer_momentary", {down(MO(1))});
+        record("layer_momentary", {down(KC_E)});
+        EXPECT_TRUE(KeyboardReport(KC_3).Matches(last_report));
+        record("layer_momentary", {up(KC_E)});
+        record("layer_momentary", {up(MO(1))});
+        settle();
+    }
+    EXPECT_LE(worst_scans("layer_momentary"), 1u);
+}
+
+TEST_F(Latency, LayerTapHold) {
+    for (unsigned n = 0; n < REPETITIONS; n++) {
+        measure({down(LT(2, KC_SPC))}, 0);
+        run_one_scan_loop();
+        // The layer only becomes active once the tapping term has passed
+        record("layer_tap_hold", {down(KC_J)});
+        EXPECT_TRUE(KeyboardReport(KC_DOWN).Matches(last_report));
+        measure({up(KC_J)});
+        measure({up(LT(2, KC_SPC))});
+        settle();
+    }
+    EXPECT_LE(worst_scans("layer_tap_hold"), TAPPING_TERM + 1u);
+}
@@ -0,0 +1,58 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {KC_LEAD, KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G},
+        {KC_NO,   KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+    },
+};
+
+static void send_1(void) { tap_code(KC_1); }
+static void send_2(void) { tap_code(KC_2); }
+static void send_3(void) { tap_code(KC_3); }
+static void send_4(void) { tap_code(KC_4); }
+static void send_5(void) { tap_code(KC_5); }
+
+const uint16_t PROGMEM leader_b[] = {KC_B, LEADER_END};
+const uint16_t PROGMEM leader_ab[] = {KC_A, KC_B, LEADER_END};
+const uint16_t PROGMEM leader_a[] = {KC_A, LEADER_END};
+const uint16_t PROGMEM leader_long[] = {KC_G, KC_F, KC_E, KC_D, KC_C, KC_B, KC_A, KC_G, LEADER_END};
+const uint16_t PROGMEM leader_ac[] = {KC_A, KC_C, LEADER_END};
+
+// Deliberately not sorted
+const leader_sequence_t PROGMEM leader_sequences[LEADER_SEQUENCE_COUNT] = {
+    LEADER_SEQUENCE(leader_b, send_1),
+    LEADER_SEQUENCE(leader_ab, send_2),
+    LEADER_SEQUENCE(leader_a, send_3),
+    LEADER_SEQUENCE(leader_long, send_4),
+    LEADER_SEQUENCE(leader_ac, send_5),
+};
+
+LEADER_EXTERNS();
+
+// The SEQ_* macros still work next to the table
+void matrix_scan_user(void) {
+    LEADER_DICTIONARY() {
+        leading = false;
+        SEQ_TWO_KEYS(KC_D, KC_C) {
+            tap_code(KC_9);
+        }
+        leader_end();
+    }
+}
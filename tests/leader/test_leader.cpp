@@ -0,0 +1,116 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+
+extern "C" {
+void advance_time(uint32_t ms);
+}
+
+class Leader : public TestFixture {
+public:
+    Leader() {
+        // The releases of the keys of a sequence are still passed on
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    }
+
+protected:
+    void tap_key(uint8_t col) {
+        press_key(col, 0);
+        run_one_scan_loop();
+        release_key(col, 0);
+        run_one_scan_loop();
+    }
+
+    // Checks that exactly one report with `keycode` is sent by `action`
+    template <typename F>
+    void expect_key(uint8_t keycode, F action) {
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(keycode)));
+        action();
+        testing::Mock::VerifyAndClearExpectations(&driver);
+        EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    }
+
+    TestDriver driver;
+};
+
+TEST_F(Leader, UnambiguousSequenceFiresRightAway) {
+    tap_key(0);
+    expect_key(KC_1, [&] { tap_key(2); });
+}
+
+TEST_F(Leader, SequenceThatStartsALongerOneWaitsForTheTimeout) {
+    tap_key(0);
+    tap_key(1);
+    idle_for(LEADER_TIMEOUT - 6);
+    expect_key(KC_3, [&] { idle_for(4); });
+}
+
+TEST_F(Leader, LongerSequenceIsPicked) {
+    tap_key(0);
+    tap_key(1);
+    expect_key(KC_5, [&] { tap_key(3); });
+}
+
+TEST_F(Leader, SequenceCanBeLongerThanFiveKeys) {
+    tap_key(0);
+    for (uint8_t col : {7, 6, 5, 4, 3, 2, 1}) {
+        tap_key(col);
+    }
+    expect_key(KC_4, [&] { tap_key(7); });
+}
+
+TEST_F(Leader, UnknownSequenceEndsTheLeaderKeyAtTheTimeout) {
+    tap_key(0);
+    tap_key(4);
+    // Still swallowed by the leader key
+    tap_key(2);
+    idle_for(LEADER_TIMEOUT);
+    // Keys are typed again
+    expect_key(KC_B, [&] { tap_key(2); });
+}
+
+TEST_F(Leader, SequenceOutsideTheTableReachesTheLeaderDictionary) {
+    tap_key(0);
+    tap_key(4);
+    tap_key(3);
+    expect_key(KC_9, [&] { idle_for(LEADER_TIMEOUT); });
+    expect_key(KC_B, [&] { tap_key(2); });
+}
+
+TEST_F(Leader, TableSequenceIsPickedWhenTheScanLoopIsSlow) {
+    tap_key(0);
+    tap_key(1);
+    // One scan that is late for both the dictionary and the deadline
+    advance_time(LEADER_TIMEOUT + 5);
+    expect_key(KC_3, [&] { run_one_scan_loop(); });
+}
+
+TEST_F(Leader, NoKeyMatchesNoSequence) {
+    tap_key(0);
+    tap_key(1);
+    // KC_NO is the LEADER_END of the sequences, it must not complete A
+    press_key(0, 1);
+    run_one_scan_loop();
+    release_key(0, 1);
+    idle_for(LEADER_TIMEOUT);
+    expect_key(KC_B, [&] { tap_key(2); });
+}
@@ -0,0 +1,39 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] = {
+        {TD(0), TD(1), TD(2), KC_Z},
+        {KC_NO, KC_NO, KC_NO, KC_NO},
+    },
+};
+
+void short_dance_finished(qk_tap_dance_state_t *state, void *user_data) {
+    register_code(state->count == 1 ? KC_C : KC_D);
+}
+
+void short_dance_reset(qk_tap_dance_state_t *state, void *user_data) {
+    unregister_code(KC_C);
+    unregister_code(KC_D);
+}
+
+qk_tap_dance_action_t tap_dance_actions[] = {
+    [0] = ACTION_TAP_DANCE_DOUBLE(KC_A, KC_B),
+    [1] = ACTION_TAP_DANCE_FN_ADVANCED_TIME(NULL, short_dance_finished, short_dance_reset, 50),
+    [2] = ACTION_TAP_DANCE_DOUBLE(KC_E, KC_F),
+};
@@ -0,0 +1,114 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+class TapDance : public TestFixture {
+public:
+    TapDance() {
+        EXPECT_CALL(driver, send_keyboard_mock(_))
+            .Times(AnyNumber())
+            .WillRepeatedly(Invoke(this, &TapDance::on_report));
+    }
+
+protected:
+    void tap_key(uint8_t col) {
+        press_key(col, 0);
+        run_one_scan_loop();
+        release_key(col, 0);
+        run_one_scan_loop();
+    }
+
+    // The reports that changed something, without the empty ones
+    std::vector<report_keyboard_t> reports;
+    report_keyboard_t last_report = {};
+    TestDriver driver;
+
+private:
+    void on_report(report_keyboard_t& report) {
+        if (!(report == last_report) && !(report == report_keyboard_t{})) {
+            reports.push_back(report);
+        }
+        last_report = report;
+    }
+};
+
+TEST_F(TapDance, SingleTapIsSentAfterTheTappingTerm) {
+    tap_key(0);
+    idle_for(TAPPING_TERM - 1);
+    EXPECT_TRUE(reports.empty());
+    idle_for(1);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_A).Matches(reports[0]));
+}
+
+TEST_F(TapDance, DoubleTapIsSentRightAway) {
+    tap_key(0);
+    tap_key(0);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_B).Matches(reports[0]));
+}
+
+TEST_F(TapDance, AnotherKeyFinishesTheDance) {
+    tap_key(0);
+    press_key(3, 0);
+    run_one_scan_loop();
+    ASSERT_EQ(2u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_A).Matches(reports[0]));
+    EXPECT_TRUE(KeyboardReport(KC_Z).Matches(reports[1]));
+}
+
+TEST_F(TapDance, ShorterTermRunsOutBehindAHeldDance) {
+    press_key(0, 0);
+    run_one_scan_loop();
+    // Finishes the held dance, but it stays active until it is released
+    tap_key(1);
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_A).Matches(reports[0]));
+    idle_for(50 - 1);
+    EXPECT_EQ(1u, reports.size());
+    idle_for(1);
+    ASSERT_EQ(3u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_A, KC_C).Matches(reports[1]));
+    EXPECT_TRUE(KeyboardReport(KC_A).Matches(reports[2]));
+    release_key(0, 0);
+    run_one_scan_loop();
+    EXPECT_EQ(3u, reports.size());
+}
+
+TEST_F(TapDance, MoreHeldDancesThanFitAreStillReleased) {
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(2, 0);
+    run_one_scan_loop();
+    tap_key(1);
+    idle_for(60);
+    release_key(0, 0);
+    release_key(2, 0);
+    run_one_scan_loop();
+    ASSERT_EQ(5u, reports.size());
+    EXPECT_TRUE(KeyboardReport(KC_A).Matches(reports[0]));
+    EXPECT_TRUE(KeyboardReport(KC_A, KC_E).Matches(reports[1]));
+    EXPECT_TRUE(KeyboardReport(KC_A, KC_E, KC_C).Matches(reports[2]));
+    EXPECT_TRUE(KeyboardReport(KC_A, KC_E).Matches(reports[3]));
+    EXPECT_TRUE(KeyboardReport(KC_E).Matches(reports[4]));
+    // Nothing is left pressed
+    EXPECT_TRUE(KeyboardReport().Matches(last_report));
+}
@@ -0,0 +1,151 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+#include <vector>
+
+using testing::_;
+using testing::AnyNumber;
+using testing::Invoke;
+
+typedef testing::Matcher<report_keyboard_t&> ReportMatcher;
+
+class Unicode : public TestFixture {
+public:
+    Unicode() {
+        EXPECT_CALL(driver, send_keyboard_mock(_))
+            .Times(AnyNumber())
+            .WillRepeatedly(Invoke(this, &Unicode::on_report));
+    }
+
+protected:
+    // Checks the sent reports, consecutive duplicates are ignored
+    void expect_reports(std::vector<ReportMatcher> expected) {
+        ASSERT_EQ(expected.size(), reports.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            EXPECT_TRUE(expected[i].Matches(reports[i])) << "report " << i;
+        }
+    }
+
+    // The keys are listed as they are down in each report
+    static void keys(std::vector<ReportMatcher>& reports, const std::vector<std::vector<uint8_t>>& states) {
+        for (auto& state : states) {
+            reports.push_back(testing::MakeMatcher(new KeyboardReportMatcher(state)));
+        }
+    }
+
+    // The session start of the Linux input mode
+    static void linux_start(std::vector<ReportMatcher>& reports) {
+        keys(reports, {{KC_LCTL}, {KC_LCTL, KC_LSFT}, {KC_LCTL, KC_LSFT, KC_U}, {KC_LCTL, KC_LSFT}, {KC_LCTL}, {}});
+    }
+
+    TestDriver driver;
+    std::vector<report_keyboard_t> reports;
+
+private:
+    void on_report(report_keyboard_t& report) {
+        if (reports.empty() || memcmp(&reports.back(), &report, sizeof(report)) != 0) {
+            reports.push_back(report);
+        }
+    }
+};
+
+// The digits share reports like send_string characters, until a digit repeats
+TEST_F(Unicode, OsxTypesTheWholeStringInOneSession) {
+    set_unicode_input_mode(UC_OSX);
+    reports.clear();
+    send_unicode_string("\xC3\xA9\xC3\xA0");
+
+    std::vector<ReportMatcher> expected;
+    keys(expected, {
+        {KC_LALT},
+        // 00E9
+        {KC_LALT, KC_0}, {KC_LALT}, {KC_LALT, KC_0}, {KC_LALT, KC_0, KC_E}, {KC_LALT, KC_0, KC_E, KC_9}, {KC_LALT},
+        // 00E0
+        {KC_LALT, KC_0}, {KC_LALT}, {KC_LALT, KC_0}, {KC_LALT, KC_0, KC_E}, {KC_LALT}, {KC_LALT, KC_0}, {KC_LALT},
+        {},
+    });
+    expect_reports(expected);
+}
+
+TEST_F(Unicode, OsxTypesSurrogatePairsOutsideTheBmp) {
+    set_unicode_input_mode(UC_OSX);
+    reports.clear();
+    // U+1F600 as UTF-8
+    send_unicode_string("\xF0\x9F\x98\x80");
+
+    std::vector<ReportMatcher> expected;
+    keys(expected, {
+        {KC_LALT},
+        // D83D
+        {KC_LALT, KC_D}, {KC_LALT, KC_D, KC_8}, {KC_LALT, KC_D, KC_8, KC_3}, {KC_LALT}, {KC_LALT, KC_D}, {KC_LALT},
+        // DE00
+        {KC_LALT, KC_D}, {KC_LALT, KC_D, KC_E}, {KC_LALT, KC_D, KC_E, KC_0}, {KC_LALT}, {KC_LALT, KC_0}, {KC_LALT},
+        {},
+    });
+    expect_reports(expected);
+}
+
+TEST_F(Unicode, LinuxStartsASessionForEveryCodePoint) {
+    set_unicode_input_mode(UC_LNX);
+    reports.clear();
+    send_unicode_hex_string("00E9 1F600");
+
+    std::vector<ReportMatcher> expected;
+    linux_start(expected);
+    keys(expected, {{KC_0}, {}, {KC_0}, {KC_0, KC_E}, {KC_0, KC_E, KC_9}, {}, {KC_SPC}, {}});
+    linux_start(expected);
+    keys(expected, {{KC_1}, {KC_1, KC_F}, {KC_1, KC_F, KC_6}, {KC_1, KC_F, KC_6, KC_0}, {}, {KC_0}, {}, {KC_SPC}, {}});
+    expect_reports(expected);
+}
+
+TEST_F(Unicode, InvalidHexTokensAreSkipped) {
+    set_unicode_input_mode(UC_LNX);
+    reports.clear();
+    send_unicode_hex_string("zz 123456789 4g 41");
+
+    std::vector<ReportMatcher> expected;
+    linux_start(expected);
+    keys(expected, {{KC_0}, {}, {KC_0}, {KC_0, KC_4}, {KC_0, KC_4, KC_1}, {}, {KC_SPC}, {}});
+    expect_reports(expected);
+}
+
+TEST_F(Unicode, InvalidUtf8IsReplaced) {
+    set_unicode_input_mode(UC_OSX);
+    reports.clear();
+    // A truncated two byte sequence followed by an ASCII character
+    send_unicode_string("\xC3" "a");
+
+    std::vector<ReportMatcher> expected;
+    keys(expected, {
+        {KC_LALT},
+        // FFFD
+        {KC_LALT, KC_F}, {KC_LALT}, {KC_LALT, KC_F}, {KC_LALT}, {KC_LALT, KC_F}, {KC_LALT, KC_F, KC_D}, {KC_LALT},
+        // 0061
+        {KC_LALT, KC_0}, {KC_LALT}, {KC_LALT, KC_0}, {KC_LALT, KC_0, KC_6}, {KC_LALT, KC_0, KC_6, KC_1}, {KC_LALT},
+        {},
+    });
+    expect_reports(expected);
+}
+
+TEST_F(Unicode, ModsAreRestoredAfterTheString) {
+    set_unicode_input_mode(UC_OSX);
+    register_code(KC_LSFT);
+    reports.clear();
+    send_unicode_string("a");
+    EXPECT_EQ(MOD_BIT(KC_LSFT), get_mods());
+    unregister_code(KC_LSFT);
+}
@@ -11,6 +11,7 @@ endif
 
 TMK_COMMON_SRC +=	$(COMMON_DIR)/host.c \
 	$(COMMON_DIR)/keyboard.c \
+	$(COMMON_DIR)/deadline.c \
 	$(COMMON_DIR)/action.c \
 	$(COMMON_DIR)/action_tapping.c \
 	$(COMMON_DIR)/action_macro.c \
@@ -36,19 +37,26 @@ ifeq ($(PLATFORM),CHIBIOS)
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
     TMK_COMMON_DEFS += -DEEPROM_EMU_STM32F303xC
     TMK_COMMON_DEFS += -DSTM32_EEPROM_ENABLE
+    EEPROM_EMU_SIZE = 0x4000
   else ifeq ($(MCU_SERIES), STM32F1xx)
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
     TMK_COMMON_DEFS += -DEEPROM_EMU_STM32F103xB
     TMK_COMMON_DEFS += -DSTM32_EEPROM_ENABLE
+    EEPROM_EMU_SIZE = 0x1000
   else ifeq ($(MCU_SERIES)_$(MCU_LDSCRIPT), STM32F0xx_STM32F072xB)
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
     TMK_COMMON_DEFS += -DEEPROM_EMU_STM32F072xB
     TMK_COMMON_DEFS += -DSTM32_EEPROM_ENABLE
+    EEPROM_EMU_SIZE = 0x4000
   else
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/eeprom_teensy.c
   endif
+  ifdef EEPROM_EMU_SIZE
+    # The pages of the emulated EEPROM, FEE_DENSITY_PAGES * FEE_PAGE_SIZE in eeprom_stm32.h
+    TMK_COMMON_LDFLAGS += -Wl,--defsym=__eeprom_emu_size__=$(EEPROM_EMU_SIZE),-T,$(PLATFORM_COMMON_DIR)/eeprom_stm32.ld
+  endif
   ifeq ($(strip $(AUTO_SHIFT_ENABLE)), yes)
     TMK_COMMON_SRC += $(CHIBIOS)/os/various/syscalls.c
   else ifeq ($(strip $(TERMINAL_ENABLE)), yes)
@@ -62,7 +70,10 @@ ifeq ($(PLATFORM),ARM_ATSAM)
 endif
 
 ifeq ($(PLATFORM),TEST)
+	# The STM32 EEPROM emulation on top of simulated flash
 	TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/eeprom.c
+	TMK_COMMON_SRC += $(COMMON_DIR)/chibios/eeprom_stm32.c
+	TMK_COMMON_DEFS += -DEEPROM_EMU_TEST
 endif
 
 
@@ -36,7 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 int tp_buttons;
 
-#ifdef RETRO_TAPPING
+#if defined(RETRO_TAPPING) || defined(TAPPING_TERM_PER_KEY)
 int retro_tapping_counter = 0;
 #endif
 
@@ -53,7 +53,7 @@ void action_exec(keyevent_t event)
     if (!IS_NOEVENT(event)) {
         dprint("\n---- action_exec: start -----\n");
         dprint("EVENT: "); debug_event(event); dprintln();
-#ifdef RETRO_TAPPING
+#if defined(RETRO_TAPPING) || defined(TAPPING_TERM_PER_KEY)
         retro_tapping_counter++;
 #endif
     }
@@ -76,15 +76,6 @@ void action_exec(keyevent_t event)
 
     keyrecord_t record = { .event = event };
 
-#if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
-    if (has_oneshot_layer_timed_out()) {
-        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
-    }
-    if (has_oneshot_mods_timed_out()) {
-        clear_oneshot_mods();
-    }
-#endif
-
 #ifndef NO_ACTION_TAPPING
     action_tapping_process(record);
 #else
@@ -173,10 +164,13 @@ void process_record(keyrecord_t *record)
 {
     if (IS_NOEVENT(record->event)) { return; }
 
+    // resolve the keycode once, every later stage reuses it
+    record->keycode = store_or_get_keycode(record->event.pressed, record->event.key);
+
     if(!process_record_quantum(record))
         return;
 
-    action_t action = store_or_get_action(record->event.pressed, record->event.key);
+    action_t action = action_for_keycode(record->keycode);
     dprint("ACTION: "); debug_action(action);
 #ifndef NO_ACTION_LAYER
     dprint(" layer_state: "); layer_debug();
@@ -652,7 +646,7 @@ void process_action(keyrecord_t *record, action_t action)
 #endif
 
 #ifndef NO_ACTION_TAPPING
-  #ifdef RETRO_TAPPING
+  #if defined(RETRO_TAPPING) || defined(TAPPING_TERM_PER_KEY)
   if (!is_tap_action(action)) {
     retro_tapping_counter = 0;
   } else {
@@ -666,7 +660,7 @@ void process_action(keyrecord_t *record, action_t action)
       if (tap_count > 0) {
         retro_tapping_counter = 0;
       } else {
-        if (retro_tapping_counter == 2) {
+        if (retro_tapping_counter == 2 && (get_tapping_flags(event.key) & TAPPING_RETRO)) {
           register_code(action.layer_tap.code);
           unregister_code(action.layer_tap.code);
         }
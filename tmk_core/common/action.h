@@ -44,6 +44,8 @@ typedef struct {
 #ifndef NO_ACTION_TAPPING
     tap_t tap;
 #endif
+    /* keycode of the key, resolved once by process_record() */
+    uint16_t keycode;
 } keyrecord_t;
 
 /* Execute action per keyevent */
@@ -52,6 +54,12 @@ void action_exec(keyevent_t event);
 /* action for key */
 action_t action_for_key(uint8_t layer, keypos_t key);
 
+/* action for keycode */
+action_t action_for_keycode(uint16_t keycode);
+
+/* keycode for key */
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
+
 /* macro */
 const macro_t *action_get_macro(keyrecord_t *record, uint8_t id, uint8_t opt);
 
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include "keyboard.h"
 #include "action.h"
 #include "util.h"
@@ -10,6 +11,21 @@
 #include "nodebug.h"
 #endif
 
+#if MAX_LAYER < 32
+/** \brief Supported Layers
+ *
+ * Layers from MAX_LAYER up are never resolved by layer_switch_get_layer(),
+ * they are turned off with a message instead of being silently ignored.
+ */
+static uint32_t supported_layers(uint32_t state) {
+  if (state >> MAX_LAYER) {
+    dprintf("only layers 0-%u are supported, ignoring %08lX\n", MAX_LAYER - 1, state & ~((1UL << MAX_LAYER) - 1));
+  }
+  return state & ((1UL << MAX_LAYER) - 1);
+}
+#else
+#define supported_layers(state) (state)
+#endif
 
 /** \brief Default Layer State
  */
@@ -38,7 +54,7 @@ uint32_t default_layer_state_set_kb(uint32_t state) {
  * Static function to set the default layer state, prints debug info and clears keys
  */
 static void default_layer_state_set(uint32_t state) {
-  state = default_layer_state_set_kb(state);
+  state = supported_layers(default_layer_state_set_kb(state));
   debug("default_layer_state: ");
   default_layer_debug(); debug(" to ");
   default_layer_state = state;
@@ -119,7 +135,7 @@ uint32_t layer_state_set_kb(uint32_t state) {
  * Sets the layer to match the specifed state (a bitmask)
  */
 void layer_state_set(uint32_t state) {
-  state = layer_state_set_kb(state);
+  state = supported_layers(layer_state_set_kb(state));
   dprint("layer_state: ");
   layer_debug(); dprint(" to ");
   layer_state = state;
@@ -220,7 +236,65 @@ void layer_debug(void) {
 #endif
 
 #if !defined(NO_ACTION_LAYER) && !defined(STRICT_LAYER_RELEASE)
+#if defined(SOURCE_LAYERS_CACHE_BYTES)
+/** \brief source layer cache
+ *
+ * One byte per key. Costs more RAM than the bit-sliced layout, but
+ * reading and writing a key is a single memory access.
+ */
+
+uint8_t source_layers_cache[MATRIX_ROWS * MATRIX_COLS] = {0};
+
+/** \brief update source layers cache
+ *
+ * Updates the cached keys when changing layers
+ */
+void update_source_layers_cache(keypos_t key, uint8_t layer) {
+  source_layers_cache[key.col + (key.row * MATRIX_COLS)] = layer;
+}
+
+/** \brief read source layers cache
+ *
+ * reads the cached keys stored when the layer was changed
+ */
+uint8_t read_source_layers_cache(keypos_t key) {
+  return source_layers_cache[key.col + (key.row * MATRIX_COLS)];
+}
+#elif defined(SOURCE_LAYERS_CACHE_NIBBLES)
+/** \brief source layer cache
+ *
+ * One nibble per key, two keys share a byte. Only layers 0-15 can be stored,
+ * so layer_switch_get_layer() ignores the higher ones (MAX_LAYER).
+ */
+
+uint8_t source_layers_cache[(MATRIX_ROWS * MATRIX_COLS + 1) / 2] = {0};
+
+/** \brief update source layers cache
+ *
+ * Updates the cached keys when changing layers
+ */
+void update_source_layers_cache(keypos_t key, uint8_t layer) {
+  const uint16_t key_number = key.col + (key.row * MATRIX_COLS);
+  const uint8_t shift = (key_number & 1) * 4;
+
+  source_layers_cache[key_number / 2] =
+    (source_layers_cache[key_number / 2] & ~(0x0F << shift)) | ((layer & 0x0F) << shift);
+}
+
+/** \brief read source layers cache
+ *
+ * reads the cached keys stored when the layer was changed
+ */
+uint8_t read_source_layers_cache(keypos_t key) {
+  const uint16_t key_number = key.col + (key.row * MATRIX_COLS);
+
+  return (source_layers_cache[key_number / 2] >> ((key_number & 1) * 4)) & 0x0F;
+}
+#else
 /** \brief source layer cache
+ *
+ * Bit-sliced, every one of the MAX_LAYER_BITS planes holds one bit of the
+ * layer number of eight keys. This is the smallest layout.
  */
 
 uint8_t source_layers_cache[(MATRIX_ROWS * MATRIX_COLS + 7) / 8][MAX_LAYER_BITS] = {{0}};
@@ -230,8 +304,8 @@ uint8_t source_layers_cache[(MATRIX_ROWS * MATRIX_COLS + 7) / 8][MAX_LAYER_BITS]
  * Updates the cached keys when changing layers
  */
 void update_source_layers_cache(keypos_t key, uint8_t layer) {
-  const uint8_t key_number = key.col + (key.row * MATRIX_COLS);
-  const uint8_t storage_row = key_number / 8;
+  const uint16_t key_number = key.col + (key.row * MATRIX_COLS);
+  const uint16_t storage_row = key_number / 8;
   const uint8_t storage_bit = key_number % 8;
 
   for (uint8_t bit_number = 0; bit_number < MAX_LAYER_BITS; bit_number++) {
@@ -247,8 +321,8 @@ void update_source_layers_cache(keypos_t key, uint8_t layer) {
  * reads the cached keys stored when the layer was changed
  */
 uint8_t read_source_layers_cache(keypos_t key) {
-  const uint8_t key_number = key.col + (key.row * MATRIX_COLS);
-  const uint8_t storage_row = key_number / 8;
+  const uint16_t key_number = key.col + (key.row * MATRIX_COLS);
+  const uint16_t storage_row = key_number / 8;
   const uint8_t storage_bit = key_number % 8;
   uint8_t layer = 0;
 
@@ -262,18 +336,18 @@ uint8_t read_source_layers_cache(keypos_t key) {
   return layer;
 }
 #endif
+#endif
 
-/** \brief Store or get action (FIXME: Needs better summary)
+/** \brief Store or get keycode
  *
- * Make sure the action triggered when the key is released is the same
- * one as the one triggered on press. It's important for the mod keys
- * when the layer is switched after the down event but before the up
- * event as they may get stuck otherwise.
+ * Resolves the keycode of a key event. The layer is looked up on press and
+ * stored in the source layers cache, so the release resolves to the keycode
+ * of the same layer even if the layer state changed in between.
  */
-action_t store_or_get_action(bool pressed, keypos_t key) {
+uint16_t store_or_get_keycode(bool pressed, keypos_t key) {
 #if !defined(NO_ACTION_LAYER) && !defined(STRICT_LAYER_RELEASE)
   if (disable_action_cache) {
-    return layer_switch_get_action(key);
+    return keymap_key_to_keycode(layer_switch_get_layer(key), key);
   }
 
   uint8_t layer;
@@ -285,12 +359,53 @@ action_t store_or_get_action(bool pressed, keypos_t key) {
   else {
     layer = read_source_layers_cache(key);
   }
-  return action_for_key(layer, key);
+  return keymap_key_to_keycode(layer, key);
 #else
-  return layer_switch_get_action(key);
+  return keymap_key_to_keycode(layer_switch_get_layer(key), key);
 #endif
 }
 
+/** \brief Store or get action (FIXME: Needs better summary)
+ *
+ * Make sure the action triggered when the key is released is the same
+ * one as the one triggered on press. It's important for the mod keys
+ * when the layer is switched after the down event but before the up
+ * event as they may get stuck otherwise.
+ */
+action_t store_or_get_action(bool pressed, keypos_t key) {
+  return action_for_keycode(store_or_get_keycode(pressed, key));
+}
+
+
+#if !defined(NO_ACTION_LAYER) && defined(LAYER_RESOLUTION_CACHE)
+/** \brief resolved layers cache
+ *
+ * Topmost non-transparent layer of every key, plus one. Zero means the key
+ * hasn't been resolved since the last layer state change.
+ */
+static uint8_t resolved_layers_cache[MATRIX_ROWS][MATRIX_COLS] = {{0}};
+/** \brief Layer state the resolved layers cache was built for
+ */
+static uint32_t resolved_layers_state = 0;
+
+/** \brief clear resolved layers cache
+ *
+ * Forgets the resolved layer of every key, they are looked up again on their next use.
+ */
+void clear_resolved_layers_cache(void) {
+  memset(resolved_layers_cache, 0, sizeof(resolved_layers_cache));
+}
+
+/** \brief invalidate resolved layer
+ *
+ * Forgets the resolved layer of a single key, call this when its keymap entry changes.
+ */
+void invalidate_resolved_layer(keypos_t key) {
+  if (key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+    resolved_layers_cache[key.row][key.col] = 0;
+  }
+}
+#endif
 
 /** \brief Layer switch get layer
  *
@@ -302,17 +417,36 @@ uint8_t layer_switch_get_layer(keypos_t key) {
   action.code = ACTION_TRANSPARENT;
 
   uint32_t layers = layer_state | default_layer_state;
+#ifdef LAYER_RESOLUTION_CACHE
+  /* the layer state is compared instead of hooking layer_state_set(), as
+   * keymaps are allowed to assign layer_state directly */
+  if (layers != resolved_layers_state) {
+    clear_resolved_layers_cache();
+    resolved_layers_state = layers;
+  }
+  const bool cacheable = key.row < MATRIX_ROWS && key.col < MATRIX_COLS;
+  if (cacheable && resolved_layers_cache[key.row][key.col]) {
+    return resolved_layers_cache[key.row][key.col] - 1;
+  }
+#endif
+  /* fall back to layer 0 */
+  uint8_t layer = 0;
   /* check top layer first */
-  for (int8_t i = 31; i >= 0; i--) {
+  for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
     if (layers & (1UL << i)) {
       action = action_for_key(i, key);
       if (action.code != ACTION_TRANSPARENT) {
-          return i;
+          layer = i;
+          break;
       }
     }
   }
-  /* fall back to layer 0 */
-  return 0;
+#ifdef LAYER_RESOLUTION_CACHE
+  if (cacheable) {
+    resolved_layers_cache[key.row][key.col] = layer + 1;
+  }
+#endif
+  return layer;
 #else
   return biton32(default_layer_state);
 #endif
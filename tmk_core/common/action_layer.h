@@ -91,11 +91,31 @@ uint32_t layer_state_set_kb(uint32_t state);
 #if !defined(NO_ACTION_LAYER) && !defined(STRICT_LAYER_RELEASE)
 /* The number of bits needed to represent the layer number: log2(32). */
 #define MAX_LAYER_BITS 5
+#ifdef SOURCE_LAYERS_CACHE_NIBBLES
+/* The nibble layout can only store layers 0-15, higher ones are never resolved. */
+#define MAX_LAYER 16
+#if defined(DYNAMIC_KEYMAP_LAYER_COUNT) && (DYNAMIC_KEYMAP_LAYER_COUNT > MAX_LAYER)
+#error "SOURCE_LAYERS_CACHE_NIBBLES supports at most 16 layers, use SOURCE_LAYERS_CACHE_BYTES"
+#endif
+#endif
 void update_source_layers_cache(keypos_t key, uint8_t layer);
 uint8_t read_source_layers_cache(keypos_t key);
 #endif
+#ifndef MAX_LAYER
+#define MAX_LAYER 32
+#endif
+uint16_t store_or_get_keycode(bool pressed, keypos_t key);
 action_t store_or_get_action(bool pressed, keypos_t key);
 
+/* resolved layer per key cache */
+#if !defined(NO_ACTION_LAYER) && defined(LAYER_RESOLUTION_CACHE)
+void clear_resolved_layers_cache(void);
+void invalidate_resolved_layer(keypos_t key);
+#else
+static inline void clear_resolved_layers_cache(void) {}
+static inline void invalidate_resolved_layer(keypos_t key) { (void)key; }
+#endif
+
 /* return the topmost non-transparent layer currently associated with key */
 uint8_t layer_switch_get_layer(keypos_t key);
 
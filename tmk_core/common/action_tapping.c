@@ -5,6 +5,8 @@
 #include "action_tapping.h"
 #include "keycode.h"
 #include "timer.h"
+#include "deadline.h"
+#include "progmem.h"
 
 #ifdef DEBUG_ACTION
 #include "debug.h"
@@ -18,13 +20,25 @@
 #define IS_TAPPING_PRESSED()    (IS_TAPPING() && tapping_key.event.pressed)
 #define IS_TAPPING_RELEASED()   (IS_TAPPING() && !tapping_key.event.pressed)
 #define IS_TAPPING_KEY(k)       (IS_TAPPING() && KEYEQ(tapping_key.event.key, (k)))
-#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < TAPPING_TERM)
+#define WITHIN_TAPPING_TERM(e)  (TIMER_DIFF_16(e.time, tapping_key.event.time) < get_tapping_term(tapping_key.event.key))
 
 
+#if WAITING_BUFFER_SIZE < 2 || WAITING_BUFFER_SIZE > 128 || (WAITING_BUFFER_SIZE & (WAITING_BUFFER_SIZE - 1))
+#error "WAITING_BUFFER_SIZE must be a power of two between 2 and 128"
+#endif
+#define WAITING_BUFFER_INDEX(i) ((i) & (WAITING_BUFFER_SIZE - 1))
+
 static keyrecord_t tapping_key = {};
+
+// The tapping term of the tapping key is settled by a tick when it runs out
+static void tapping_term_expired(void) { action_exec(TICK); }
+static deadline_t tapping_deadline = DEADLINE(tapping_term_expired);
 static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE] = {};
+/* head and tail run freely, head - tail is the number of waiting records */
 static uint8_t waiting_buffer_head = 0;
 static uint8_t waiting_buffer_tail = 0;
+static uint8_t waiting_buffer_max = 0;
+static uint16_t waiting_buffer_overflow_count = 0;
 
 static bool process_tapping(keyrecord_t *record);
 static bool waiting_buffer_enq(keyrecord_t record);
@@ -36,6 +50,41 @@ static void debug_tapping_key(void);
 static void debug_waiting_buffer(void);
 
 
+/** \brief Get tapping term
+ *
+ * The tapping term of the key at a matrix position, from the tapping_terms table
+ * when TAPPING_TERM_PER_KEY is defined.
+ */
+uint16_t get_tapping_term(keypos_t key)
+{
+#ifdef TAPPING_TERM_PER_KEY
+    uint16_t term = pgm_read_word(&tapping_terms[key.row][key.col]) & TAPPING_TERM_MASK;
+    if (term) return term;
+#endif
+    return TAPPING_TERM;
+}
+
+/** \brief Get tapping flags
+ *
+ * The TAPPING_* policy flags of the key at a matrix position.
+ */
+uint16_t get_tapping_flags(keypos_t key)
+{
+    uint16_t flags = 0;
+#ifdef PERMISSIVE_HOLD
+    flags |= TAPPING_PERMISSIVE_HOLD;
+#endif
+#ifdef RETRO_TAPPING
+    flags |= TAPPING_RETRO;
+#endif
+#ifdef TAPPING_TERM_PER_KEY
+    flags |= pgm_read_word(&tapping_terms[key.row][key.col]) & ~TAPPING_TERM_MASK;
+#endif
+    // long terms are too slow to wait for the tapping key release
+    if (get_tapping_term(key) >= 500) flags |= TAPPING_PERMISSIVE_HOLD;
+    return flags;
+}
+
 /** \brief Action Tapping Process
  *
  * FIXME: Needs doc
@@ -49,6 +98,8 @@ void action_tapping_process(keyrecord_t record)
     } else {
         if (!waiting_buffer_enq(record)) {
             // clear all in case of overflow.
+            // keyboard_task() doesn't read more keys than waiting_buffer_free(), so only other callers get here
+            if (waiting_buffer_overflow_count < UINT16_MAX) waiting_buffer_overflow_count++;
             debug("OVERFLOW: CLEAR ALL STATES\n");
             clear_keyboard();
             waiting_buffer_clear();
@@ -60,10 +111,11 @@ void action_tapping_process(keyrecord_t record)
     if (!IS_NOEVENT(record.event) && waiting_buffer_head != waiting_buffer_tail) {
         debug("---- action_exec: process waiting_buffer -----\n");
     }
-    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
-        if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
-            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
-            debug_record(waiting_buffer[waiting_buffer_tail]); debug("\n\n");
+    for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail++) {
+        keyrecord_t *record = &waiting_buffer[WAITING_BUFFER_INDEX(waiting_buffer_tail)];
+        if (process_tapping(record)) {
+            debug("processed: waiting_buffer["); debug_dec(WAITING_BUFFER_INDEX(waiting_buffer_tail)); debug("] = ");
+            debug_record(*record); debug("\n\n");
         } else {
             break;
         }
@@ -71,6 +123,14 @@ void action_tapping_process(keyrecord_t record)
     if (!IS_NOEVENT(record.event)) {
         debug("\n");
     }
+
+    // A tick is stamped like a key event, with its time rounded up to an odd number, so it
+    // can see the term run out 1 ms early. If it doesn't, the deadline is set again.
+    if (IS_TAPPING() && (int16_t)(timer_read() - tapping_key.event.time) < get_tapping_term(tapping_key.event.key)) {
+        deadline_set(&tapping_deadline, tapping_key.event.time, get_tapping_term(tapping_key.event.key) - 1);
+    } else {
+        deadline_cancel(&tapping_deadline);
+    }
 }
 
 
@@ -100,12 +160,12 @@ bool process_tapping(keyrecord_t *keyp)
                     // enqueue
                     return false;
                 }
-#if TAPPING_TERM >= 500 || defined PERMISSIVE_HOLD
                 /* Process a key typed within TAPPING_TERM
                  * This can register the key before settlement of tapping,
                  * useful for long TAPPING_TERM but may prevent fast typing.
                  */
-                else if (IS_RELEASED(event) && waiting_buffer_typed(event)) {
+                else if (IS_RELEASED(event) && (get_tapping_flags(tapping_key.event.key) & TAPPING_PERMISSIVE_HOLD) &&
+                         waiting_buffer_typed(event)) {
                     debug("Tapping: End. No tap. Interfered by typing key\n");
                     process_record(&tapping_key);
                     tapping_key = (keyrecord_t){};
@@ -113,7 +173,6 @@ bool process_tapping(keyrecord_t *keyp)
                     // enqueue
                     return false;
                 }
-#endif
                 /* Process release event of a key pressed before tapping starts
                  * Without this unexpected repeating will occur with having fast repeating setting
                  * https://github.com/tmk/tmk_keyboard/issues/60
@@ -142,6 +201,13 @@ bool process_tapping(keyrecord_t *keyp)
                     // set interrupted flag when other key preesed during tapping
                     if (event.pressed) {
                         tapping_key.tap.interrupted = true;
+                        /* Settle as hold without waiting for the rest of the term */
+                        if (get_tapping_flags(tapping_key.event.key) & TAPPING_HOLD_ON_OTHER_KEY_PRESS) {
+                            debug("Tapping: End. No tap. Interfered by pressed key\n");
+                            process_record(&tapping_key);
+                            tapping_key = (keyrecord_t){};
+                            debug_tapping_key();
+                        }
                     }
                     // enqueue
                     return false;
@@ -303,13 +369,17 @@ bool waiting_buffer_enq(keyrecord_t record)
         return true;
     }
 
-    if ((waiting_buffer_head + 1) % WAITING_BUFFER_SIZE == waiting_buffer_tail) {
+    uint8_t used = waiting_buffer_head - waiting_buffer_tail;
+    if (used == WAITING_BUFFER_SIZE) {
         debug("waiting_buffer_enq: Over flow.\n");
         return false;
     }
 
-    waiting_buffer[waiting_buffer_head] = record;
-    waiting_buffer_head = (waiting_buffer_head + 1) % WAITING_BUFFER_SIZE;
+    waiting_buffer[WAITING_BUFFER_INDEX(waiting_buffer_head)] = record;
+    waiting_buffer_head++;
+    if (used + 1 > waiting_buffer_max) {
+        waiting_buffer_max = used + 1;
+    }
 
     debug("waiting_buffer_enq: "); debug_waiting_buffer();
     return true;
@@ -325,13 +395,42 @@ void waiting_buffer_clear(void)
     waiting_buffer_tail = 0;
 }
 
+/** \brief Waiting buffer free
+ *
+ * Number of key events that can still be handed to action_exec() without overflowing
+ * the waiting buffer. keyboard_task() leaves further matrix changes for later scans.
+ */
+uint8_t waiting_buffer_free(void)
+{
+    return WAITING_BUFFER_SIZE - (uint8_t)(waiting_buffer_head - waiting_buffer_tail);
+}
+
+/** \brief Waiting buffer high water
+ *
+ * Most key events that were waiting at the same time, to help choose WAITING_BUFFER_SIZE.
+ */
+uint8_t waiting_buffer_high_water(void)
+{
+    return waiting_buffer_max;
+}
+
+/** \brief Waiting buffer overflows
+ *
+ * Number of times the waiting buffer was full and all key states were cleared.
+ */
+uint16_t waiting_buffer_overflows(void)
+{
+    return waiting_buffer_overflow_count;
+}
+
 /** \brief Waiting buffer typed
  *
  * FIXME: Needs docs
  */
 bool waiting_buffer_typed(keyevent_t event)
 {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t n = waiting_buffer_tail; n != waiting_buffer_head; n++) {
+        uint8_t i = WAITING_BUFFER_INDEX(n);
         if (KEYEQ(event.key, waiting_buffer[i].event.key) && event.pressed !=  waiting_buffer[i].event.pressed) {
             return true;
         }
@@ -346,7 +445,8 @@ bool waiting_buffer_typed(keyevent_t event)
 __attribute__((unused))
 bool waiting_buffer_has_anykey_pressed(void)
 {
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t n = waiting_buffer_tail; n != waiting_buffer_head; n++) {
+        uint8_t i = WAITING_BUFFER_INDEX(n);
         if (waiting_buffer[i].event.pressed) return true;
     }
     return false;
@@ -363,7 +463,8 @@ void waiting_buffer_scan_tap(void)
     // invalid state: tapping_key released && tap.count == 0
     if (!tapping_key.event.pressed) return;
 
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t n = waiting_buffer_tail; n != waiting_buffer_head; n++) {
+        uint8_t i = WAITING_BUFFER_INDEX(n);
         if (IS_TAPPING_KEY(waiting_buffer[i].event.key) &&
                 !waiting_buffer[i].event.pressed &&
                 WITHIN_TAPPING_TERM(waiting_buffer[i].event)) {
@@ -395,7 +496,8 @@ static void debug_tapping_key(void)
 static void debug_waiting_buffer(void)
 {
     debug("{ ");
-    for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
+    for (uint8_t n = waiting_buffer_tail; n != waiting_buffer_head; n++) {
+        uint8_t i = WAITING_BUFFER_INDEX(n);
         debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer[i]); debug(" ");
     }
     debug("}\n");
@@ -17,6 +17,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ACTION_TAPPING_H
 #define ACTION_TAPPING_H
 
+#include <stdint.h>
+#include "keyboard.h"
 
 
 /* period of tapping(ms) */
@@ -31,11 +33,37 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define TAPPING_TOGGLE  5
 #endif
 
+/* key events that can wait for a tapping key to settle, a power of two */
+#ifndef WAITING_BUFFER_SIZE
 #define WAITING_BUFFER_SIZE 8
+#endif
+
 
+/* Per key tapping settings, entries of the tapping_terms table
+ *
+ * The low bits are the tapping term in ms, 0 for TAPPING_TERM. The policy
+ * flags are added to the ones set globally with PERMISSIVE_HOLD and RETRO_TAPPING.
+ */
+#define TAPPING_TERM_MASK               0x0FFF
+/* a key typed within the term makes it a hold */
+#define TAPPING_PERMISSIVE_HOLD         0x1000
+/* any other key pressed within the term makes it a hold right away */
+#define TAPPING_HOLD_ON_OTHER_KEY_PRESS 0x2000
+/* tap anyway after the term, as long as no other key was pressed */
+#define TAPPING_RETRO                   0x4000
+
+#ifdef TAPPING_TERM_PER_KEY
+/* indexed by matrix position, provided by the keymap */
+extern const uint16_t tapping_terms[MATRIX_ROWS][MATRIX_COLS];
+#endif
 
 #ifndef NO_ACTION_TAPPING
+uint16_t get_tapping_term(keypos_t key);
+uint16_t get_tapping_flags(keypos_t key);
 void action_tapping_process(keyrecord_t record);
+uint8_t waiting_buffer_free(void);
+uint8_t waiting_buffer_high_water(void);
+uint16_t waiting_buffer_overflows(void);
 #endif
 
 #endif
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "action_util.h"
 #include "action_layer.h"
 #include "timer.h"
+#include "deadline.h"
 #include "keycode_config.h"
 
 extern keymap_config_t keymap_config;
@@ -65,6 +66,7 @@ void clear_oneshot_locked_mods(void) {
 }
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
 static uint16_t oneshot_time = 0;
+static deadline_t oneshot_mods_deadline = DEADLINE(clear_oneshot_mods);
 bool has_oneshot_mods_timed_out(void) {
   return TIMER_DIFF_16(timer_read(), oneshot_time) >= ONESHOT_TIMEOUT;
 }
@@ -94,6 +96,12 @@ inline bool has_oneshot_layer_timed_out() {
     return TIMER_DIFF_16(timer_read(), oneshot_layer_time) >= ONESHOT_TIMEOUT &&
         !(get_oneshot_layer_state() & ONESHOT_TOGGLED);
 }
+static void oneshot_layer_expired(void) {
+    if (has_oneshot_layer_timed_out()) {
+        clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
+    }
+}
+static deadline_t oneshot_layer_deadline = DEADLINE(oneshot_layer_expired);
 #endif
 
 /** \brief Set oneshot layer 
@@ -106,6 +114,7 @@ void set_oneshot_layer(uint8_t layer, uint8_t state)
     layer_on(layer);
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
     oneshot_layer_time = timer_read();
+    deadline_set(&oneshot_layer_deadline, oneshot_layer_time, ONESHOT_TIMEOUT);
 #endif
     oneshot_layer_changed_kb(get_oneshot_layer());
 }
@@ -117,6 +126,7 @@ void reset_oneshot_layer(void) {
     oneshot_layer_data = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
     oneshot_layer_time = 0;
+    deadline_cancel(&oneshot_layer_deadline);
 #endif
     oneshot_layer_changed_kb(get_oneshot_layer());
 }
@@ -257,6 +267,7 @@ void set_oneshot_mods(uint8_t mods) {
   if (oneshot_mods != mods) {
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
     oneshot_time = timer_read();
+    deadline_set(&oneshot_mods_deadline, oneshot_time, ONESHOT_TIMEOUT);
 #endif
     oneshot_mods = mods;
     oneshot_mods_changed_kb(mods);
@@ -271,6 +282,7 @@ void clear_oneshot_mods(void) {
     oneshot_mods = 0;
 #if (defined(ONESHOT_TIMEOUT) && (ONESHOT_TIMEOUT > 0))
     oneshot_time = 0;
+    deadline_cancel(&oneshot_mods_deadline);
 #endif
     oneshot_mods_changed_kb(oneshot_mods);
   }
@@ -2,6 +2,10 @@
 #include "i2c_master.h"
 #include "led_matrix.h"
 #include "suspend.h"
+#include "eeconfig.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+  #include "dynamic_keymap.h"
+#endif
 
 /** \brief Suspend idle
  *
@@ -40,6 +44,11 @@ void suspend_power_down(void)
 #endif
 
     suspend_power_down_kb();
+    // settings may not survive if the host cuts the power while suspended
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    dynamic_keymap_flush();
+#endif
+    eeconfig_flush();
 }
 
 __attribute__ ((weak)) void matrix_power_up(void) {}
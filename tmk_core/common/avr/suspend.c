@@ -9,6 +9,10 @@
 #include "suspend.h"
 #include "timer.h"
 #include "led.h"
+#include "eeconfig.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+  #include "dynamic_keymap.h"
+#endif
 #include "host.h"
 #include "rgblight_reconfig.h"
 
@@ -159,6 +163,11 @@ static void power_down(uint8_t wdto) {
  */
 void suspend_power_down(void) {
 	suspend_power_down_kb();
+	// settings may not survive if the host cuts the power while suspended
+#ifdef DYNAMIC_KEYMAP_ENABLE
+	dynamic_keymap_flush();
+#endif
+	eeconfig_flush();
 
 #ifndef NO_SUSPEND_POWER_DOWN
     power_down(WDTO_15MS);
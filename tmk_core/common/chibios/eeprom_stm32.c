@@ -18,23 +18,164 @@
 
 #include <stdio.h>
 #include <string.h>
+#include "eeprom.h"
 #include "eeprom_stm32.h"
 /*****************************************************************************
  * Allows to use the internal flash to store non volatile data. To initialize
  * the functionality use the EEPROM_Init() function. Be sure that by reprogramming
  * of the controller just affected pages will be deleted. In other case the non
  * volatile data will be lost.
+ *
+ * The pages are split into two banks, only one of them is in use at a time:
+ *
+ *   | magic | generation | snapshot of the EEPROM | log entry | log entry | ...
+ *
+ * The whole EEPROM is kept in RAM, so reads never touch the flash. At boot the
+ * snapshot of the bank in use is copied to RAM, and the write log is replayed
+ * on top of it. A write appends a log entry with the new value of the aligned
+ * halfword, the value first and its index last, so an entry torn by a power
+ * loss is ignored. Once the log is full, the RAM copy becomes the snapshot of
+ * the other bank, which is only marked valid by its magic after everything
+ * else is written, and then the old bank is erased. So every page is erased
+ * once per two full logs, and a power loss at any point leaves a valid bank
+ * behind.
 ******************************************************************************/
 
 /* Private macro -------------------------------------------------------------*/
+#define FEE_BANK_ADDRESS(Bank)      (FEE_PAGE_BASE_ADDRESS + (Bank) * FEE_BANK_SIZE)
+#define FEE_SNAPSHOT_ADDRESS(Bank)  (FEE_BANK_ADDRESS(Bank) + FEE_HEADER_SIZE)
+#define FEE_LOG_ADDRESS(Bank)       (FEE_SNAPSHOT_ADDRESS(Bank) + FEE_DENSITY_BYTES)
+
 /* Private variables ---------------------------------------------------------*/
+static uint16_t DataBuf[FEE_DENSITY_BYTES / 2];
+static bool DataLoaded = false;
+static uint8_t ActiveBank;
+static uint16_t Generation;
+static uint16_t LogUsed;
+
 /* Functions -----------------------------------------------------------------*/
 
-uint8_t DataBuf[FEE_PAGE_SIZE];
+static bool EEPROM_BankIsValid(uint8_t Bank) {
+    return FLASH_ReadHalfWord(FEE_BANK_ADDRESS(Bank)) == FEE_BANK_MAGIC;
+}
+
+static void EEPROM_EraseBank(uint8_t Bank) {
+    for (uint16_t page = 0; page < FEE_BANK_PAGES; page++) {
+        FLASH_ErasePage(FEE_BANK_ADDRESS(Bank) + page * FEE_PAGE_SIZE);
+    }
+}
+
+static bool EEPROM_BankIsErased(uint8_t Bank) {
+    for (uint32_t offset = 0; offset < FEE_BANK_SIZE; offset += 2) {
+        if (FLASH_ReadHalfWord(FEE_BANK_ADDRESS(Bank) + offset) != FEE_EMPTY_WORD) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /*****************************************************************************
-*  Delete Flash Space used for user Data, deletes the whole space between
-*  RW_PAGE_BASE_ADDRESS and the last uC Flash Page
+*  Writes the RAM copy as the snapshot of the other bank, switches to it and
+*  erases the old one.
 ******************************************************************************/
+static FLASH_Status EEPROM_Compact(void) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    uint8_t bank = ActiveBank ^ 1;
+
+    // The other bank was erased when it was left, unless the power was lost
+    if (!EEPROM_BankIsErased(bank)) {
+        EEPROM_EraseBank(bank);
+    }
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES / 2; i++) {
+        if (DataBuf[i] != FEE_EMPTY_WORD) {
+            FlashStatus = FLASH_ProgramHalfWord(FEE_SNAPSHOT_ADDRESS(bank) + i * 2, DataBuf[i]);
+        }
+    }
+    FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank) + 2, Generation + 1);
+    // The new bank only becomes valid with its magic
+    FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank), FEE_BANK_MAGIC);
+    EEPROM_EraseBank(ActiveBank);
+
+    ActiveBank = bank;
+    Generation++;
+    LogUsed = 0;
+    return FlashStatus;
+}
+
+/*****************************************************************************
+*  Appends the current value of the halfword with the given index to the log.
+******************************************************************************/
+static FLASH_Status EEPROM_AppendLog(uint16_t Index) {
+    if (LogUsed >= FEE_LOG_ENTRIES) {
+        // The snapshot already contains the new value
+        return EEPROM_Compact();
+    }
+
+    uint32_t entry = FEE_LOG_ADDRESS(ActiveBank) + LogUsed * FEE_LOG_ENTRY_SIZE;
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    LogUsed++;
+    if (DataBuf[Index] != FEE_EMPTY_WORD) {
+        FlashStatus = FLASH_ProgramHalfWord(entry, DataBuf[Index]);
+    }
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(entry + 2, Index);
+    }
+    return FlashStatus;
+}
+
+/*****************************************************************************
+*  Rebuilds the RAM copy from the flash.
+******************************************************************************/
+static void EEPROM_Load(void) {
+    bool valid0 = EEPROM_BankIsValid(0);
+    bool valid1 = EEPROM_BankIsValid(1);
+
+    DataLoaded = true;
+    LogUsed = 0;
+
+    if (!valid0 && !valid1) {
+        // Nothing written in this format yet, take over what the old format
+        // stored in the low byte of every halfword and start over in bank 0.
+        // The old pages are bank 1, which is only erased once bank 0 holds
+        // all of their data.
+        uint8_t *bytes = (uint8_t *)DataBuf;
+        for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+            bytes[i] = i < FEE_LEGACY_DENSITY_BYTES ? FLASH_ReadHalfWord(FEE_LEGACY_BASE_ADDRESS + i * 2) & 0xFF : 0xFF;
+        }
+        ActiveBank = 1;
+        Generation = 0;
+        EEPROM_Compact();
+        return;
+    }
+
+    if (valid0 && valid1) {
+        // A power loss right after a compaction, the newer bank wins
+        int16_t age = FLASH_ReadHalfWord(FEE_BANK_ADDRESS(1) + 2) - FLASH_ReadHalfWord(FEE_BANK_ADDRESS(0) + 2);
+        ActiveBank = age > 0 ? 1 : 0;
+    } else {
+        ActiveBank = valid1 ? 1 : 0;
+    }
+    Generation = FLASH_ReadHalfWord(FEE_BANK_ADDRESS(ActiveBank) + 2);
+
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES / 2; i++) {
+        DataBuf[i] = FLASH_ReadHalfWord(FEE_SNAPSHOT_ADDRESS(ActiveBank) + i * 2);
+    }
+    for (uint16_t entry = 0; entry < FEE_LOG_ENTRIES; entry++) {
+        uint32_t address = FEE_LOG_ADDRESS(ActiveBank) + entry * FEE_LOG_ENTRY_SIZE;
+        uint16_t value = FLASH_ReadHalfWord(address);
+        uint16_t index = FLASH_ReadHalfWord(address + 2);
+        if (value == FEE_EMPTY_WORD && index == FEE_EMPTY_WORD) {
+            // Entries are appended in order, the rest of the log is empty
+            break;
+        }
+        LogUsed = entry + 1;
+        // A torn entry has no index yet
+        if (index < FEE_DENSITY_BYTES / 2) {
+            DataBuf[index] = value;
+        }
+    }
+}
+
 uint16_t EEPROM_Init(void) {
     // unlock flash
     FLASH_Unlock();
@@ -42,66 +183,55 @@ uint16_t EEPROM_Init(void) {
     // Clear Flags
     //FLASH_ClearFlag(FLASH_SR_EOP|FLASH_SR_PGERR|FLASH_SR_WRPERR);
 
+    EEPROM_Load();
     return FEE_DENSITY_BYTES;
 }
 /*****************************************************************************
-*  Erase the whole reserved Flash Space used for user Data
+*  Erase the whole emulated EEPROM
 ******************************************************************************/
 void EEPROM_Erase (void) {
-
-    int page_num = 0;
-
-    // delete all pages from specified start page to the last page
-    do {
-        FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
-        page_num++;
-    } while (page_num < FEE_DENSITY_PAGES);
+    if (!DataLoaded) {
+        EEPROM_Init();
+    }
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    EEPROM_Compact();
 }
 /*****************************************************************************
-*  Writes once data byte to flash on specified address. If a byte is already
-*  written, the whole page must be copied to a buffer, the byte changed and
-*  the manipulated buffer written after PageErase.
+*  Writes once data byte, the flash is only written when the value changes.
 *******************************************************************************/
 uint16_t EEPROM_WriteDataByte (uint16_t Address, uint8_t DataByte) {
-
+    return EEPROM_WriteDataBlock(Address, &DataByte, 1);
+}
+/*****************************************************************************
+*  Writes a block of data, one log entry per changed halfword.
+*******************************************************************************/
+uint16_t EEPROM_WriteDataBlock (uint16_t Address, const uint8_t *Data, uint16_t Length) {
     FLASH_Status FlashStatus = FLASH_COMPLETE;
+    uint8_t *bytes = (uint8_t *)DataBuf;
 
-    uint32_t page;
-    int i;
+    if (!DataLoaded) {
+        EEPROM_Init();
+    }
 
-    // exit if desired address is above the limit (e.G. under 2048 Bytes for 4 pages)
-    if (Address > FEE_DENSITY_BYTES) {
+    // exit if desired address is above the limit
+    if (Address >= FEE_DENSITY_BYTES) {
         return 0;
     }
+    if (Length > FEE_DENSITY_BYTES - Address) {
+        Length = FEE_DENSITY_BYTES - Address;
+    }
 
-    // calculate which page is affected (Pagenum1/Pagenum2...PagenumN)
-    page = FEE_ADDR_OFFSET(Address) / FEE_PAGE_SIZE;
-
-    // if current data is 0xFF, the byte is empty, just overwrite with the new one
-    if ((*(__IO uint16_t*)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) == FEE_EMPTY_WORD) {
-
-        FlashStatus = FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address), (uint16_t)(0x00FF & DataByte));
-    } else {
-
-        // Copy Page to a buffer
-        memcpy(DataBuf, (uint8_t*)FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE), FEE_PAGE_SIZE); // !!! Calculate base address for the desired page
-
-        // check if new data is differ to current data, return if not, proceed if yes
-        if (DataByte == *(__IO uint8_t*)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) {
-            return 0;
-        }
-
-        // manipulate desired data byte in temp data array if new byte is differ to the current
-        DataBuf[FEE_ADDR_OFFSET(Address) % FEE_PAGE_SIZE] = DataByte;
-
-        //Erase Page
-        FlashStatus = FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE));
-
-        // Write new data (whole page) to flash if data has been changed
-        for(i = 0; i < (FEE_PAGE_SIZE / 2); i++) {
-            if ((__IO uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]) != 0xFFFF) {
-                FlashStatus = FLASH_ProgramHalfWord((FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE)) + (i * 2), (uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]));
-            }
+    while (Length) {
+        uint16_t index = Address / 2;
+        uint16_t old = DataBuf[index];
+        // Update the one or two bytes of this halfword
+        do {
+            bytes[Address++] = *Data++;
+            Length--;
+        } while (Length && Address % 2);
+
+        if (DataBuf[index] != old) {
+            FlashStatus = EEPROM_AppendLog(index);
         }
     }
     return FlashStatus;
@@ -110,13 +240,25 @@ uint16_t EEPROM_WriteDataByte (uint16_t Address, uint8_t DataByte) {
 *  Read once data byte from a specified address.
 *******************************************************************************/
 uint8_t EEPROM_ReadDataByte (uint16_t Address) {
-
-    uint8_t DataByte = 0xFF;
-
-    // Get Byte from specified address
-    DataByte = (*(__IO uint8_t*)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address)));
-
-    return DataByte;
+    if (!DataLoaded) {
+        EEPROM_Init();
+    }
+    if (Address >= FEE_DENSITY_BYTES) {
+        return 0xFF;
+    }
+    return ((uint8_t *)DataBuf)[Address];
+}
+/*****************************************************************************
+*  Read a block of data, bytes past the end read as 0xFF.
+*******************************************************************************/
+void EEPROM_ReadDataBlock (uint16_t Address, uint8_t *Data, uint16_t Length) {
+    if (!DataLoaded) {
+        EEPROM_Init();
+    }
+    uint16_t available = Address < FEE_DENSITY_BYTES ? FEE_DENSITY_BYTES - Address : 0;
+    uint16_t count = Length < available ? Length : available;
+    memcpy(Data, (uint8_t *)DataBuf + Address, count);
+    memset(Data + count, 0xFF, Length - count);
 }
 
 /*****************************************************************************
@@ -124,91 +266,64 @@ uint8_t EEPROM_ReadDataByte (uint16_t Address) {
 *******************************************************************************/
 uint8_t eeprom_read_byte (const uint8_t *Address)
 {
-    const uint16_t p = (const uint32_t) Address;
+    const uint16_t p = (uintptr_t) Address;
     return EEPROM_ReadDataByte(p);
 }
 
 void eeprom_write_byte (uint8_t *Address, uint8_t Value)
 {
-    uint16_t p = (uint32_t) Address;
+    uint16_t p = (uintptr_t) Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 void eeprom_update_byte (uint8_t *Address, uint8_t Value)
 {
-    uint16_t p = (uint32_t) Address;
+    uint16_t p = (uintptr_t) Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 uint16_t eeprom_read_word (const uint16_t *Address)
 {
-    const uint16_t p = (const uint32_t) Address;
-    return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p+1) << 8);
+    uint16_t Value;
+    eeprom_read_block(&Value, Address, sizeof(Value));
+    return Value;
 }
 
 void eeprom_write_word (uint16_t *Address, uint16_t Value)
 {
-    uint16_t p = (uint32_t) Address;
-    EEPROM_WriteDataByte(p, (uint8_t) Value);
-    EEPROM_WriteDataByte(p + 1, (uint8_t) (Value >> 8));
+    eeprom_write_block(&Value, Address, sizeof(Value));
 }
 
 void eeprom_update_word (uint16_t *Address, uint16_t Value)
 {
-    uint16_t p = (uint32_t) Address;
-    EEPROM_WriteDataByte(p, (uint8_t) Value);
-    EEPROM_WriteDataByte(p + 1, (uint8_t) (Value >> 8));
+    eeprom_write_block(&Value, Address, sizeof(Value));
 }
 
 uint32_t eeprom_read_dword (const uint32_t *Address)
 {
-    const uint16_t p = (const uint32_t) Address;
-    return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p+1) << 8)
-        | (EEPROM_ReadDataByte(p+2) << 16) | (EEPROM_ReadDataByte(p+3) << 24);
+    uint32_t Value;
+    eeprom_read_block(&Value, Address, sizeof(Value));
+    return Value;
 }
 
 void eeprom_write_dword (uint32_t *Address, uint32_t Value)
 {
-    uint16_t p = (const uint32_t) Address;
-    EEPROM_WriteDataByte(p, (uint8_t) Value);
-    EEPROM_WriteDataByte(p+1, (uint8_t) (Value >> 8));
-    EEPROM_WriteDataByte(p+2, (uint8_t) (Value >> 16));
-    EEPROM_WriteDataByte(p+3, (uint8_t) (Value >> 24));
+    eeprom_write_block(&Value, Address, sizeof(Value));
 }
 
 void eeprom_update_dword (uint32_t *Address, uint32_t Value)
 {
-    uint16_t p = (const uint32_t) Address;
-    uint32_t existingValue = EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p+1) << 8)
-        | (EEPROM_ReadDataByte(p+2) << 16) | (EEPROM_ReadDataByte(p+3) << 24);
-    if(Value != existingValue){
-      EEPROM_WriteDataByte(p, (uint8_t) Value);
-      EEPROM_WriteDataByte(p+1, (uint8_t) (Value >> 8));
-      EEPROM_WriteDataByte(p+2, (uint8_t) (Value >> 16));
-      EEPROM_WriteDataByte(p+3, (uint8_t) (Value >> 24));
-    }
+    eeprom_write_block(&Value, Address, sizeof(Value));
 }
 
 void eeprom_read_block(void *buf, const void *addr, uint32_t len) {
-    const uint8_t *p = (const uint8_t *)addr;
-    uint8_t *dest = (uint8_t *)buf;
-    while (len--) {
-        *dest++ = eeprom_read_byte(p++);
-    }
+    EEPROM_ReadDataBlock((uintptr_t)addr, (uint8_t *)buf, len);
 }
 
 void eeprom_write_block(const void *buf, void *addr, uint32_t len) {
-    uint8_t *p = (uint8_t *)addr;
-    const uint8_t *src = (const uint8_t *)buf;
-    while (len--) {
-        eeprom_write_byte(p++, *src++);
-    }
+    EEPROM_WriteDataBlock((uintptr_t)addr, (const uint8_t *)buf, len);
 }
 
 void eeprom_update_block(const void *buf, void *addr, uint32_t len) {
-    uint8_t *p = (uint8_t *)addr;
-    const uint8_t *src = (const uint8_t *)buf;
-    while (len--) {
-        eeprom_write_byte(p++, *src++);
-    }
+    EEPROM_WriteDataBlock((uintptr_t)addr, (const uint8_t *)buf, len);
 }
@@ -17,15 +17,15 @@
  *
  * This library assumes 8-bit data locations. To add a new MCU, please provide the flash
  * page size and the total flash size in Kb. The number of available pages must be a multiple
- * of 2. Only half of the pages account for the total EEPROM size.
- * This library also assumes that the pages are not used by the firmware.
+ * of 2, the pages are used as two banks that take turns.
+ * The build keeps the firmware out of these pages, see eeprom_stm32.ld.
  */
 
 #ifndef __EEPROM_H
 #define __EEPROM_H
 
-#include "ch.h"
-#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
 #include "flash_stm32.h"
 
 // HACK ALERT. This definition may not match your processor
@@ -36,24 +36,34 @@
   #define MCU_STM32F103RB
 #elif defined(EEPROM_EMU_STM32F072xB)
   #define MCU_STM32F072CB
+#elif defined(EEPROM_EMU_TEST)
+  #define MCU_TEST
 #else
   #error "not implemented."
 #endif
 
 #ifndef EEPROM_PAGE_SIZE
     #if defined (MCU_STM32F103RB)
-        #define FEE_PAGE_SIZE    (uint16_t)0x400 // Page size = 1KByte
-        #define FEE_DENSITY_PAGES          2     // How many pages are used
-    #elif defined (MCU_STM32F103ZE) || defined (MCU_STM32F103RE) || defined (MCU_STM32F103RD) || defined (MCU_STM32F303CC) || defined(MCU_STM32F072CB)
-        #define FEE_PAGE_SIZE    (uint16_t)0x800 // Page size = 2KByte
+        #define FEE_PAGE_SIZE    0x400 // Page size = 1KByte
         #define FEE_DENSITY_PAGES          4     // How many pages are used
+    #elif defined (MCU_STM32F103ZE) || defined (MCU_STM32F103RE) || defined (MCU_STM32F103RD) || defined (MCU_STM32F303CC) || defined(MCU_STM32F072CB)
+        #define FEE_PAGE_SIZE    0x800 // Page size = 2KByte
+        #define FEE_DENSITY_PAGES          8     // How many pages are used
+    #elif defined (MCU_TEST)
+        // The native test platform simulates the flash, the unit tests pick a smaller geometry
+        #ifndef FEE_PAGE_SIZE
+            #define FEE_PAGE_SIZE    0x400
+        #endif
+        #ifndef FEE_DENSITY_PAGES
+            #define FEE_DENSITY_PAGES          4
+        #endif
     #else
         #error  "No MCU type specified. Add something like -DMCU_STM32F103RB to your compiler arguments (probably in a Makefile)."
     #endif
 #endif
 
 #ifndef EEPROM_START_ADDRESS
-    #if defined (MCU_STM32F103RB) || defined(MCU_STM32F072CB)
+    #if defined (MCU_STM32F103RB) || defined(MCU_STM32F072CB) || defined(MCU_TEST)
         #define FEE_MCU_FLASH_SIZE  128     // Size in Kb
     #elif defined (MCU_STM32F103ZE) || defined (MCU_STM32F103RE)
         #define FEE_MCU_FLASH_SIZE  512     // Size in Kb
@@ -66,18 +76,59 @@
     #endif
 #endif
 
+// Size of the emulated EEPROM, which is also kept in RAM. The rest of a bank
+// (half of the pages) is used for the write log.
+#ifndef FEE_DENSITY_BYTES
+    #if defined (MCU_STM32F103RB) || defined (MCU_TEST)
+        #define FEE_DENSITY_BYTES   1024
+    #else
+        #define FEE_DENSITY_BYTES   4096
+    #endif
+#endif
+
 // DONT CHANGE
 // Choose location for the first EEPROM Page address on the top of flash
 #define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
-#define FEE_DENSITY_BYTES       ((FEE_PAGE_SIZE / 2) * FEE_DENSITY_PAGES - 1)
 #define FEE_LAST_PAGE_ADDRESS   (FEE_PAGE_BASE_ADDRESS + (FEE_PAGE_SIZE * FEE_DENSITY_PAGES))
+#define FEE_BANK_PAGES          (FEE_DENSITY_PAGES / 2)
+#define FEE_BANK_SIZE           ((uint32_t)FEE_PAGE_SIZE * FEE_BANK_PAGES)
+#define FEE_HEADER_SIZE         4
+#define FEE_LOG_ENTRY_SIZE      4
+#define FEE_LOG_ENTRIES         ((FEE_BANK_SIZE - FEE_HEADER_SIZE - FEE_DENSITY_BYTES) / FEE_LOG_ENTRY_SIZE)
 #define FEE_EMPTY_WORD          ((uint16_t)0xFFFF)
-#define FEE_ADDR_OFFSET(Address)(Address * 2) // 1Byte per Word will be saved to preserve Flash
+#define FEE_BANK_MAGIC          ((uint16_t)0x51E7)
+
+// Pages used by the old format, which kept one byte per halfword in the top
+// half of the pages used now. Its data is taken over from there the first time
+// the new format is loaded.
+#ifndef FEE_LEGACY_DENSITY_PAGES
+    #define FEE_LEGACY_DENSITY_PAGES   (FEE_DENSITY_PAGES / 2)
+#endif
+#define FEE_LEGACY_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_LEGACY_DENSITY_PAGES * FEE_PAGE_SIZE))
+#define FEE_LEGACY_DENSITY_BYTES ((FEE_PAGE_SIZE / 2) * FEE_LEGACY_DENSITY_PAGES - 1)
+
+#if FEE_LEGACY_DENSITY_PAGES > FEE_DENSITY_PAGES / 2
+    #error "The old format has to fit in bank 1, so that bank 0 can take its data over before it is erased"
+#endif
+#if FEE_DENSITY_BYTES < FEE_LEGACY_DENSITY_BYTES
+    #error "FEE_DENSITY_BYTES has to hold all the data of the old format"
+#endif
+#if FEE_DENSITY_PAGES % 2 != 0
+    #error "FEE_DENSITY_PAGES must be a multiple of 2"
+#endif
+#if FEE_DENSITY_BYTES % 2 != 0
+    #error "FEE_DENSITY_BYTES must be even"
+#endif
+#if FEE_HEADER_SIZE + FEE_DENSITY_BYTES + 16 * FEE_LOG_ENTRY_SIZE > FEE_PAGE_SIZE * (FEE_DENSITY_PAGES / 2)
+    #error "FEE_DENSITY_BYTES leaves too little room for the write log, use more pages or a smaller size"
+#endif
 
 // Use this function to initialize the functionality
 uint16_t EEPROM_Init(void);
 void EEPROM_Erase (void);
 uint16_t EEPROM_WriteDataByte (uint16_t Address, uint8_t DataByte);
 uint8_t EEPROM_ReadDataByte (uint16_t Address);
+void EEPROM_ReadDataBlock (uint16_t Address, uint8_t *Data, uint16_t Length);
+uint16_t EEPROM_WriteDataBlock (uint16_t Address, const uint8_t *Data, uint16_t Length);
 
 #endif  /* __EEPROM_H */
@@ -164,7 +164,17 @@ void eeprom_read_block(void *buf, const void *addr, uint32_t len)
 	if (!(FTFL->FCNFG & FTFL_FCNFG_EEERDY)) eeprom_initialize();
 	if (end > EEPROM_SIZE) end = EEPROM_SIZE;
 	while (offset < end) {
-		*dest++ = FlexRAM[offset++];
+		if ((offset & 3) == 0 && end - offset >= 4) {
+			// read aligned 32 bits
+			uint32_t val32 = *(uint32_t *)(&FlexRAM[offset]);
+			*dest++ = val32;
+			*dest++ = val32 >> 8;
+			*dest++ = val32 >> 16;
+			*dest++ = val32 >> 24;
+			offset += 4;
+		} else {
+			*dest++ = FlexRAM[offset++];
+		}
 	}
 }
 
@@ -294,7 +304,7 @@ void eeprom_write_block(const void *buf, void *addr, uint32_t len)
 	if (offset >= EEPROM_SIZE) return;
 	if (!(FTFL->FCNFG & FTFL_FCNFG_EEERDY)) eeprom_initialize();
 	if (len >= EEPROM_SIZE) len = EEPROM_SIZE;
-	if (offset + len >= EEPROM_SIZE) len = EEPROM_SIZE - offset;
+	if (offset + len > EEPROM_SIZE) len = EEPROM_SIZE - offset;
 	while (len > 0) {
 		uint32_t lsb = offset & 3;
 		if (lsb == 0 && len >= 4) {
@@ -603,30 +613,36 @@ void eeprom_write_block(const void *buf, void *addr, uint32_t len) {
 }
 
 #endif /* chip selection */
-// The update functions just calls write for now, but could probably be optimized
+// The update functions only write what changed. Reading is cheap on all of
+// the backends, writing takes a flash operation or a FlexRAM backup cycle.
 
 void eeprom_update_byte(uint8_t *addr, uint8_t value) {
-	eeprom_write_byte(addr, value);
+	if (eeprom_read_byte(addr) != value) {
+		eeprom_write_byte(addr, value);
+	}
 }
 
 void eeprom_update_word(uint16_t *addr, uint16_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p, value >> 8);
+	if (eeprom_read_word(addr) != value) {
+		eeprom_write_word(addr, value);
+	}
 }
 
 void eeprom_update_dword(uint32_t *addr, uint32_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p++, value >> 8);
-	eeprom_write_byte(p++, value >> 16);
-	eeprom_write_byte(p, value >> 24);
+	if (eeprom_read_dword(addr) != value) {
+		eeprom_write_dword(addr, value);
+	}
 }
 
 void eeprom_update_block(const void *buf, void *addr, uint32_t len) {
+#if defined(K20x)
+	// Writes aligned words at once and already skips the unchanged ones
+	eeprom_write_block(buf, addr, len);
+#else
 	uint8_t *p = (uint8_t *)addr;
 	const uint8_t *src = (const uint8_t *)buf;
 	while (len--) {
-		eeprom_write_byte(p++, *src++);
+		eeprom_update_byte(p++, *src++);
 	}
+#endif
 }
@@ -23,8 +23,12 @@
  extern "C" {
 #endif
 
+#include <stdint.h>
+
+#ifndef EEPROM_EMU_TEST
 #include "ch.h"
 #include "hal.h"
+#endif
 
 typedef enum
     {
@@ -42,6 +46,7 @@ typedef enum
 FLASH_Status FLASH_WaitForLastOperation(uint32_t Timeout);
 FLASH_Status FLASH_ErasePage(uint32_t Page_Address);
 FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data);
+uint16_t FLASH_ReadHalfWord(uint32_t Address);
 
 void FLASH_Unlock(void);
 void FLASH_Lock(void);
@@ -11,6 +11,10 @@
 #include "backlight.h"
 #include "suspend.h"
 #include "wait.h"
+#include "eeconfig.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+  #include "dynamic_keymap.h"
+#endif
 
 /** \brief suspend idle
  *
@@ -46,6 +50,11 @@ void suspend_power_down(void) {
 	// also shouldn't power down USB
 
   suspend_power_down_kb();
+  // settings may not survive if the host cuts the power while suspended
+#ifdef DYNAMIC_KEYMAP_ENABLE
+  dynamic_keymap_flush();
+#endif
+  eeconfig_flush();
 	// on AVR, this enables the watchdog for 15ms (max), and goes to
 	// SLEEP_MODE_PWR_DOWN
 
@@ -0,0 +1,129 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include "timer.h"
+#include "deadline.h"
+
+// Pending deadlines, the one that expires first at the front
+static deadline_t *deadlines = NULL;
+// Passed deadlines whose callbacks deadline_task() is about to call
+static deadline_t *expiring = NULL;
+
+/* Time left at `now`, negative when the deadline has passed
+ *
+ * Key event times are rounded up to an odd number and can be 1 ms ahead of
+ * timer_read(), so `start` may be in the future.
+ */
+static int32_t time_left(const deadline_t *deadline, uint16_t now) {
+    return (int32_t)deadline->timeout - (int16_t)(now - deadline->start);
+}
+
+/** \brief Set a deadline
+ *
+ * The callback of the deadline is called by deadline_task() once `timeout` ms
+ * have passed since `start`. Setting a pending deadline moves it.
+ */
+void deadline_set(deadline_t *deadline, uint16_t start, uint16_t timeout) {
+    deadline_cancel(deadline);
+    deadline->start = start;
+    deadline->timeout = timeout;
+    deadline->pending = true;
+
+    uint16_t now = timer_read();
+    int32_t left = time_left(deadline, now);
+    deadline_t **link = &deadlines;
+    while (*link && time_left(*link, now) <= left) {
+        link = &(*link)->next;
+    }
+    deadline->next = *link;
+    *link = deadline;
+}
+
+/** \brief Cancel a deadline
+ *
+ * Does nothing when the deadline isn't pending.
+ */
+void deadline_cancel(deadline_t *deadline) {
+    if (!deadline->pending) {
+        return;
+    }
+    // a callback may cancel a deadline that deadline_task() has detached already
+    deadline_t **list = &deadlines;
+    for (uint8_t i = 0; i < 2; i++, list = &expiring) {
+        for (deadline_t **link = list; *link; link = &(*link)->next) {
+            if (*link == deadline) {
+                *link = deadline->next;
+                deadline->next = NULL;
+                deadline->pending = false;
+                return;
+            }
+        }
+    }
+    deadline->next = NULL;
+    deadline->pending = false;
+}
+
+/** \brief Is the deadline waiting to expire
+ */
+bool deadline_pending(const deadline_t *deadline) {
+    return deadline->pending;
+}
+
+/** \brief Time until the next deadline
+ *
+ * In ms, 0 when a deadline has already passed and DEADLINE_NONE when none is pending.
+ */
+uint16_t deadline_next(void) {
+    if (!deadlines) {
+        return DEADLINE_NONE;
+    }
+    int32_t left = time_left(deadlines, timer_read());
+    if (left <= 0) {
+        return 0;
+    }
+    return left < DEADLINE_NONE ? left : DEADLINE_NONE - 1;
+}
+
+/** \brief Deadline task
+ *
+ * Calls the callbacks of all deadlines that have passed, in expiry order.
+ * A callback may set its own or any other deadline again, if that one has
+ * passed already it's called by the next deadline_task().
+ */
+void deadline_task(void) {
+    uint16_t now = timer_read();
+    deadline_t **link = &deadlines;
+    while (*link && time_left(*link, now) <= 0) {
+        link = &(*link)->next;
+    }
+    if (link == &deadlines) {
+        return;
+    }
+    // detach the passed ones first, so deadlines set by the callbacks wait for the next task
+    expiring = deadlines;
+    deadlines = *link;
+    *link = NULL;
+    while (expiring) {
+        deadline_t *deadline = expiring;
+        expiring = deadline->next;
+        deadline->next = NULL;
+        deadline->pending = false;
+        if (deadline->expired) {
+            deadline->expired();
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Shared timeout service
+ *
+ * Features that wait for a timeout keep a deadline_t and set it instead of
+ * checking timer_elapsed() on every scan. The pending deadlines are kept in
+ * expiry order, so deadline_task() only has to look at the first one, and
+ * deadline_next() tells how long the keyboard can sleep if the matrix doesn't
+ * change. Timeouts can be up to 32767 ms.
+ */
+typedef struct deadline_t {
+    struct deadline_t *next;
+    void (*expired)(void);
+    uint16_t start;
+    uint16_t timeout;
+    bool pending;
+} deadline_t;
+
+#define DEADLINE(callback) { .expired = (callback) }
+
+/* deadline_next() when no deadline is pending */
+#define DEADLINE_NONE UINT16_MAX
+
+void deadline_set(deadline_t *deadline, uint16_t start, uint16_t timeout);
+void deadline_cancel(deadline_t *deadline);
+bool deadline_pending(const deadline_t *deadline);
+uint16_t deadline_next(void);
+void deadline_task(void);
+
+#endif
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include "config.h"
 #include "eeprom.h"
 #include "eeconfig.h"
 
@@ -9,6 +10,180 @@
 #endif
 
 extern uint32_t default_layer_state;
+
+// Bytes handed to the eeconfig_update functions, and bytes that actually had to be written
+static uint32_t bytes_requested = 0;
+static uint32_t bytes_written = 0;
+
+/* Writes `size` bytes to EEPROM, skipping the write when nothing changed */
+static void eeconfig_write_block(const uint8_t *data, uint16_t offset, uint8_t size) {
+  uint8_t *address = (uint8_t *)EECONFIG_MAGIC + offset;
+  uint8_t changed = 0;
+  for (uint8_t i = 0; i < size; i++) {
+    if (eeprom_read_byte(address + i) != data[i]) {
+      changed++;
+    }
+  }
+  if (changed) {
+    eeprom_update_block(data, address, size);
+    bytes_written += changed;
+  }
+}
+
+#ifdef EECONFIG_CACHE
+
+#include "timer.h"
+#include "deadline.h"
+
+#ifndef EECONFIG_WRITE_DELAY
+#define EECONFIG_WRITE_DELAY 1000
+#endif
+
+#if EECONFIG_SIZE > 32
+#error EECONFIG_SIZE is too big for the dirty bitmap of the EECONFIG_CACHE
+#endif
+
+// RAM copy of the eeconfig block, settings are read from here. Changes are
+// written back once no further change came in for EECONFIG_WRITE_DELAY
+// milliseconds, so stepping through hue or brightness writes only once.
+static uint8_t eeconfig_cache[EECONFIG_SIZE];
+static uint32_t eeconfig_cache_dirty = 0;
+static bool eeconfig_cache_loaded = false;
+
+static deadline_t eeconfig_cache_deadline = DEADLINE(eeconfig_flush);
+
+static void eeconfig_cache_load(void) {
+  eeprom_read_block(eeconfig_cache, EECONFIG_MAGIC, EECONFIG_SIZE);
+  eeconfig_cache_loaded = true;
+}
+
+/* Forgets the RAM copy and pending changes, for when the EEPROM is erased underneath it */
+static void eeconfig_cache_discard(void) {
+  deadline_cancel(&eeconfig_cache_deadline);
+  eeconfig_cache_dirty = 0;
+  eeconfig_cache_loaded = false;
+}
+
+/** \brief eeconfig flush
+ *
+ * Writes the pending changes to EEPROM right away.
+ */
+void eeconfig_flush(void) {
+  deadline_cancel(&eeconfig_cache_deadline);
+  uint8_t offset = 0;
+  while (eeconfig_cache_dirty) {
+    // write every run of consecutive changed bytes as one block
+    while (!(eeconfig_cache_dirty & 1)) {
+      eeconfig_cache_dirty >>= 1;
+      offset++;
+    }
+    uint8_t size = 0;
+    while (eeconfig_cache_dirty & 1) {
+      eeconfig_cache_dirty >>= 1;
+      size++;
+    }
+    eeconfig_write_block(&eeconfig_cache[offset], offset, size);
+    offset += size;
+  }
+}
+
+#else
+
+static void eeconfig_cache_discard(void) {
+}
+
+/** \brief eeconfig flush
+ *
+ * Changes are written right away without the EECONFIG_CACHE, so there is nothing to flush.
+ */
+void eeconfig_flush(void) {
+}
+
+#endif // EECONFIG_CACHE
+
+/* Reads a little endian value of `size` bytes */
+static uint32_t eeconfig_read(const void *addr, uint8_t size) {
+  uint8_t data[4];
+#ifdef EECONFIG_CACHE
+  uint16_t offset = (uintptr_t)addr;
+  if (offset + size <= EECONFIG_SIZE) {
+    if (!eeconfig_cache_loaded) {
+      eeconfig_cache_load();
+    }
+    for (uint8_t i = 0; i < size; i++) {
+      data[i] = eeconfig_cache[offset + i];
+    }
+  } else
+#endif
+  {
+    eeprom_read_block(data, addr, size);
+  }
+  uint32_t value = 0;
+  for (uint8_t i = size; i-- > 0; ) {
+    value = value << 8 | data[i];
+  }
+  return value;
+}
+
+/* Stores a little endian value of `size` bytes */
+static void eeconfig_update(void *addr, uint32_t value, uint8_t size) {
+  uint16_t offset = (uintptr_t)addr;
+  uint8_t data[4];
+  for (uint8_t i = 0; i < size; i++) {
+    data[i] = value;
+    value >>= 8;
+  }
+  bytes_requested += size;
+#ifdef EECONFIG_CACHE
+  if (offset + size <= EECONFIG_SIZE) {
+    if (!eeconfig_cache_loaded) {
+      eeconfig_cache_load();
+    }
+    bool changed = false;
+    for (uint8_t i = 0; i < size; i++) {
+      if (eeconfig_cache[offset + i] != data[i]) {
+        eeconfig_cache[offset + i] = data[i];
+        eeconfig_cache_dirty |= (uint32_t)1 << (offset + i);
+        changed = true;
+      }
+    }
+    if (changed) {
+      // every further change postpones the write, so a burst of changes is written once
+      deadline_set(&eeconfig_cache_deadline, timer_read(), EECONFIG_WRITE_DELAY);
+    }
+    return;
+  }
+#endif
+  eeconfig_write_block(data, offset, size);
+}
+
+/** \brief eeconfig read byte
+ *
+ * Reads a setting byte, including changes that haven't been written to EEPROM yet.
+ */
+uint8_t eeconfig_read_byte(const uint8_t *addr)    { return eeconfig_read(addr, 1); }
+uint16_t eeconfig_read_word(const uint16_t *addr)  { return eeconfig_read(addr, 2); }
+uint32_t eeconfig_read_dword(const uint32_t *addr) { return eeconfig_read(addr, 4); }
+
+/** \brief eeconfig update byte
+ *
+ * Stores a setting byte. With the EECONFIG_CACHE the EEPROM write is deferred.
+ */
+void eeconfig_update_byte(uint8_t *addr, uint8_t val)    { eeconfig_update(addr, val, 1); }
+void eeconfig_update_word(uint16_t *addr, uint16_t val)  { eeconfig_update(addr, val, 2); }
+void eeconfig_update_dword(uint32_t *addr, uint32_t val) { eeconfig_update(addr, val, 4); }
+
+/** \brief eeconfig bytes requested
+ *
+ * Number of bytes passed to the eeconfig_update functions since startup.
+ */
+uint32_t eeconfig_bytes_requested(void) { return bytes_requested; }
+
+/** \brief eeconfig bytes written
+ *
+ * Number of EEPROM bytes that were actually changed since startup.
+ */
+uint32_t eeconfig_bytes_written(void) { return bytes_written; }
 /** \brief eeconfig enable
  *
  * FIXME: needs doc
@@ -32,23 +207,25 @@ void eeconfig_init_kb(void) {
  * FIXME: needs doc
  */
 void eeconfig_init_quantum(void) {
+  eeconfig_cache_discard();
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
 #endif
-  eeprom_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
-  eeprom_update_byte(EECONFIG_DEBUG,          0);
-  eeprom_update_byte(EECONFIG_DEFAULT_LAYER,  0);
+  eeconfig_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
+  eeconfig_update_byte(EECONFIG_DEBUG,          0);
+  eeconfig_update_byte(EECONFIG_DEFAULT_LAYER,  0);
   default_layer_state = 0;
-  eeprom_update_byte(EECONFIG_KEYMAP,         0);
-  eeprom_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
-  eeprom_update_byte(EECONFIG_BACKLIGHT,      0);
-  eeprom_update_byte(EECONFIG_AUDIO,             0xFF); // On by default
-  eeprom_update_dword(EECONFIG_RGBLIGHT,      0);
-  eeprom_update_byte(EECONFIG_STENOMODE,      0);
-  eeprom_update_dword(EECONFIG_HAPTIC,        0);
-  eeprom_update_byte(EECONFIG_VELOCIKEY,      0);
+  eeconfig_update_byte(EECONFIG_KEYMAP,         0);
+  eeconfig_update_byte(EECONFIG_MOUSEKEY_ACCEL, 0);
+  eeconfig_update_byte(EECONFIG_BACKLIGHT,      0);
+  eeconfig_update_byte(EECONFIG_AUDIO,             0xFF); // On by default
+  eeconfig_update_dword(EECONFIG_RGBLIGHT,      0);
+  eeconfig_update_byte(EECONFIG_STENOMODE,      0);
+  eeconfig_update_dword(EECONFIG_HAPTIC,        0);
+  eeconfig_update_byte(EECONFIG_VELOCIKEY,      0);
 
   eeconfig_init_kb();
+  eeconfig_flush();
 }
 
 /** \brief eeconfig initialization
@@ -66,7 +243,8 @@ void eeconfig_init(void) {
  */
 void eeconfig_enable(void)
 {
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER);
+    eeconfig_flush();
 }
 
 /** \brief eeconfig disable
@@ -75,10 +253,12 @@ void eeconfig_enable(void)
  */
 void eeconfig_disable(void)
 {
+    eeconfig_cache_discard();
 #ifdef STM32_EEPROM_ENABLE
     EEPROM_Erase();
 #endif
-    eeprom_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_update_word(EECONFIG_MAGIC, EECONFIG_MAGIC_NUMBER_OFF);
+    eeconfig_flush();
 }
 
 /** \brief eeconfig is enabled
@@ -87,7 +267,7 @@ void eeconfig_disable(void)
  */
 bool eeconfig_is_enabled(void)
 {
-    return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
+    return (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER);
 }
 
 /** \brief eeconfig is disabled
@@ -96,94 +276,94 @@ bool eeconfig_is_enabled(void)
  */
 bool eeconfig_is_disabled(void)
 {
-    return (eeprom_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF);
+    return (eeconfig_read_word(EECONFIG_MAGIC) == EECONFIG_MAGIC_NUMBER_OFF);
 }
 
 /** \brief eeconfig read debug
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_debug(void)      { return eeprom_read_byte(EECONFIG_DEBUG); }
+uint8_t eeconfig_read_debug(void)      { return eeconfig_read_byte(EECONFIG_DEBUG); }
 /** \brief eeconfig update debug
  *
  * FIXME: needs doc
  */
-void eeconfig_update_debug(uint8_t val) { eeprom_update_byte(EECONFIG_DEBUG, val); }
+void eeconfig_update_debug(uint8_t val) { eeconfig_update_byte(EECONFIG_DEBUG, val); }
 
 /** \brief eeconfig read default layer
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_default_layer(void)      { return eeprom_read_byte(EECONFIG_DEFAULT_LAYER); }
+uint8_t eeconfig_read_default_layer(void)      { return eeconfig_read_byte(EECONFIG_DEFAULT_LAYER); }
 /** \brief eeconfig update default layer
  *
  * FIXME: needs doc
  */
-void eeconfig_update_default_layer(uint8_t val) { eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val); }
+void eeconfig_update_default_layer(uint8_t val) { eeconfig_update_byte(EECONFIG_DEFAULT_LAYER, val); }
 
 /** \brief eeconfig read keymap
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_keymap(void)      { return eeprom_read_byte(EECONFIG_KEYMAP); }
+uint8_t eeconfig_read_keymap(void)      { return eeconfig_read_byte(EECONFIG_KEYMAP); }
 /** \brief eeconfig update keymap
  *
  * FIXME: needs doc
  */
-void eeconfig_update_keymap(uint8_t val) { eeprom_update_byte(EECONFIG_KEYMAP, val); }
+void eeconfig_update_keymap(uint8_t val) { eeconfig_update_byte(EECONFIG_KEYMAP, val); }
 
 /** \brief eeconfig read backlight
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_backlight(void)      { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
+uint8_t eeconfig_read_backlight(void)      { return eeconfig_read_byte(EECONFIG_BACKLIGHT); }
 /** \brief eeconfig update backlight
  *
  * FIXME: needs doc
  */
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_byte(EECONFIG_BACKLIGHT, val); }
 
 
 /** \brief eeconfig read audio
  *
  * FIXME: needs doc
  */
-uint8_t eeconfig_read_audio(void)      { return eeprom_read_byte(EECONFIG_AUDIO); }
+uint8_t eeconfig_read_audio(void)      { return eeconfig_read_byte(EECONFIG_AUDIO); }
 /** \brief eeconfig update audio
  *
  * FIXME: needs doc
  */
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_byte(EECONFIG_AUDIO, val); }
 
 
 /** \brief eeconfig read kb
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_kb(void)      { return eeprom_read_dword(EECONFIG_KEYBOARD); }
+uint32_t eeconfig_read_kb(void)      { return eeconfig_read_dword(EECONFIG_KEYBOARD); }
 /** \brief eeconfig update kb
  *
  * FIXME: needs doc
  */
 
-void eeconfig_update_kb(uint32_t val) { eeprom_update_dword(EECONFIG_KEYBOARD, val); }
+void eeconfig_update_kb(uint32_t val) { eeconfig_update_dword(EECONFIG_KEYBOARD, val); }
 /** \brief eeconfig read user
  *
  * FIXME: needs doc
  */
-uint32_t eeconfig_read_user(void)      { return eeprom_read_dword(EECONFIG_USER); }
+uint32_t eeconfig_read_user(void)      { return eeconfig_read_dword(EECONFIG_USER); }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
-void eeconfig_update_user(uint32_t val) { eeprom_update_dword(EECONFIG_USER, val); }
+void eeconfig_update_user(uint32_t val) { eeconfig_update_dword(EECONFIG_USER, val); }
 
 
-uint32_t eeconfig_read_haptic(void)      { return eeprom_read_dword(EECONFIG_HAPTIC); }
+uint32_t eeconfig_read_haptic(void)      { return eeconfig_read_dword(EECONFIG_HAPTIC); }
 /** \brief eeconfig update user
  *
  * FIXME: needs doc
  */
-void eeconfig_update_haptic(uint32_t val) { eeprom_update_dword(EECONFIG_HAPTIC, val); }
+void eeconfig_update_haptic(uint32_t val) { eeconfig_update_dword(EECONFIG_HAPTIC, val); }
 
 
@@ -44,6 +44,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define EECONFIG_HAPTIC                            (uint32_t*)24
 
+/* Size of the block above, kept in RAM by the EECONFIG_CACHE */
+#define EECONFIG_SIZE                               28
+
 /* debug bit */
 #define EECONFIG_DEBUG_ENABLE                       (1<<0)
 #define EECONFIG_DEBUG_MATRIX                       (1<<1)
@@ -73,6 +76,17 @@ void eeconfig_enable(void);
 
 void eeconfig_disable(void);
 
+uint8_t eeconfig_read_byte(const uint8_t *addr);
+uint16_t eeconfig_read_word(const uint16_t *addr);
+uint32_t eeconfig_read_dword(const uint32_t *addr);
+void eeconfig_update_byte(uint8_t *addr, uint8_t val);
+void eeconfig_update_word(uint16_t *addr, uint16_t val);
+void eeconfig_update_dword(uint32_t *addr, uint32_t val);
+void eeconfig_flush(void);
+
+uint32_t eeconfig_bytes_requested(void);
+uint32_t eeconfig_bytes_written(void);
+
 uint8_t eeconfig_read_debug(void);
 void eeconfig_update_debug(uint8_t val);
 
@@ -31,6 +31,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "action_layer.h"
+#include "action_tapping.h"
+#include "deadline.h"
 #ifdef BOOTMAGIC_ENABLE
 #   include "bootmagic.h"
 #else
@@ -79,6 +81,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
   #include "velocikey.h"
 #endif
 
+/* Maximum number of matrix changes queued and processed by one keyboard_task() call */
+#ifndef QMK_KEYS_PER_SCAN
+#   define QMK_KEYS_PER_SCAN 8
+#endif
+
 #ifdef MATRIX_HAS_GHOST
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
 static matrix_row_t get_real_keys(uint8_t row, matrix_row_t rowdata){
@@ -258,13 +265,20 @@ void keyboard_task(void)
     static uint8_t led_status = 0;
     matrix_row_t matrix_row = 0;
     matrix_row_t matrix_change = 0;
-#ifdef QMK_KEYS_PER_SCAN
-    uint8_t keys_processed = 0;
-#endif
+    keyevent_t event_queue[QMK_KEYS_PER_SCAN];
+    uint8_t events = 0;
 
     matrix_scan();
 
     if (is_keyboard_master()) {
+        // all edges found in this scan share its timestamp
+        const uint16_t time = timer_read() | 1; /* time should not be 0 */
+        uint8_t max_events = QMK_KEYS_PER_SCAN;
+#ifndef NO_ACTION_TAPPING
+        // don't read more edges than the tapping waiting buffer can take,
+        // the others stay in the matrix until it has drained
+        if (waiting_buffer_free() < max_events) max_events = waiting_buffer_free();
+#endif
         for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
             matrix_row = matrix_get_row(r);
             matrix_change = matrix_row ^ matrix_prev[r];
@@ -275,32 +289,34 @@ void keyboard_task(void)
                 if (debug_matrix) matrix_print();
                 for (uint8_t c = 0; c < MATRIX_COLS; c++) {
                     if (matrix_change & ((matrix_row_t)1<<c)) {
-                        action_exec((keyevent_t){
+                        // the remaining changes are picked up by a later scan
+                        if (events >= max_events) goto MATRIX_LOOP_END;
+                        event_queue[events++] = (keyevent_t){
                             .key = (keypos_t){ .row = r, .col = c },
                             .pressed = (matrix_row & ((matrix_row_t)1<<c)),
-                            .time = (timer_read() | 1) /* time should not be 0 */
-                        });
-                        // record a processed key
+                            .time = time
+                        };
+                        // record a queued key
                         matrix_prev[r] ^= ((matrix_row_t)1<<c);
-#ifdef QMK_KEYS_PER_SCAN
-                        // only jump out if we have processed "enough" keys.
-                        if (++keys_processed >= QMK_KEYS_PER_SCAN)
-#endif
-                        // process a key per task call
-                        goto MATRIX_LOOP_END;
                     }
                 }
             }
         }
     }
-    // call with pseudo tick event when no real key event.
-#ifdef QMK_KEYS_PER_SCAN
-    // we can get here with some keys processed now.
-    if (!keys_processed)
-#endif
-    action_exec(TICK);
 
 MATRIX_LOOP_END:
+    // timeouts that passed before this scan come before its key events
+    deadline_task();
+    // drain the queue in the order the edges were found, which is time order
+    for (uint8_t i = 0; i < events; i++) {
+        action_exec(event_queue[i]);
+    }
+#ifdef FAUXCLICKY_ENABLE
+    // fauxclicky_check() runs on every tick, the other timeouts set deadlines
+    if (!events) {
+        action_exec(TICK);
+    }
+#endif
 
 #ifdef QWIIC_ENABLE
     qwiic_task();
@@ -72,6 +72,17 @@ void matrix_print(void);
 void matrix_power_up(void);
 void matrix_power_down(void);
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+/* scan on change */
+/* whether scanning is paused until a key is pressed, the main loop then sleeps */
+bool matrix_is_idle(void);
+/* arm and disarm the pin interrupts on the matrix inputs, weak */
+void matrix_wakeup_enable(void);
+void matrix_wakeup_disable(void);
+/* to be called from the pin interrupt handler */
+void matrix_wakeup_isr(void);
+#endif
+
 /* executes code for Quantum */
 void matrix_init_quantum(void);
 void matrix_scan_quantum(void);
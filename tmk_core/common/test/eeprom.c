@@ -14,85 +14,101 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "eeprom.h"
-
-#define EEPROM_SIZE 32
+/* Simulated flash for the STM32 EEPROM emulation in chibios/eeprom_stm32.c,
+ * which provides the EEPROM functions on the test platform as well.
+ *
+ * Like the real flash, a page can only be erased as a whole, and a halfword
+ * can only be programmed once after that. The erases of every page are
+ * counted, and a power loss can be simulated after a number of erase and
+ * program operations, all operations after it are lost.
+ */
 
-static uint8_t buffer[EEPROM_SIZE];
+#include <stdbool.h>
+#include <string.h>
+#include "common/chibios/eeprom_stm32.h"
 
-uint8_t eeprom_read_byte(const uint8_t *addr) {
-	uintptr_t offset = (uintptr_t)addr;
-	return buffer[offset];
-}
+static uint16_t flash[FEE_DENSITY_PAGES * FEE_PAGE_SIZE / 2] = { [0 ... FEE_DENSITY_PAGES * FEE_PAGE_SIZE / 2 - 1] = FEE_EMPTY_WORD };
+static uint32_t erase_counts[FEE_DENSITY_PAGES];
+static uint32_t program_errors = 0;
+static int32_t operations_left = -1;
 
-void eeprom_write_byte(uint8_t *addr, uint8_t value) {
-	uintptr_t offset = (uintptr_t)addr;
-	buffer[offset] = value;
+static bool flash_powered(void) {
+	if (operations_left < 0) {
+		return true;
+	}
+	if (operations_left == 0) {
+		return false;
+	}
+	operations_left--;
+	return true;
 }
 
-uint16_t eeprom_read_word(const uint16_t *addr) {
-	const uint8_t *p = (const uint8_t *)addr;
-	return eeprom_read_byte(p) | (eeprom_read_byte(p+1) << 8);
+static bool flash_in_range(uint32_t address) {
+	return address >= FEE_PAGE_BASE_ADDRESS && address < FEE_LAST_PAGE_ADDRESS && address % 2 == 0;
 }
 
-uint32_t eeprom_read_dword(const uint32_t *addr) {
-	const uint8_t *p = (const uint8_t *)addr;
-	return eeprom_read_byte(p) | (eeprom_read_byte(p+1) << 8)
-		| (eeprom_read_byte(p+2) << 16) | (eeprom_read_byte(p+3) << 24);
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address) {
+	if (!flash_in_range(Page_Address) || (Page_Address - FEE_PAGE_BASE_ADDRESS) % FEE_PAGE_SIZE) {
+		return FLASH_BAD_ADDRESS;
+	}
+	if (!flash_powered()) {
+		return FLASH_TIMEOUT;
+	}
+	uint32_t page = (Page_Address - FEE_PAGE_BASE_ADDRESS) / FEE_PAGE_SIZE;
+	memset(&flash[page * FEE_PAGE_SIZE / 2], 0xFF, FEE_PAGE_SIZE);
+	erase_counts[page]++;
+	return FLASH_COMPLETE;
 }
 
-void eeprom_read_block(void *buf, const void *addr, uint32_t len) {
-	const uint8_t *p = (const uint8_t *)addr;
-	uint8_t *dest = (uint8_t *)buf;
-	while (len--) {
-		*dest++ = eeprom_read_byte(p++);
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data) {
+	if (!flash_in_range(Address)) {
+		return FLASH_BAD_ADDRESS;
+	}
+	if (!flash_powered()) {
+		return FLASH_TIMEOUT;
 	}
+	uint16_t *halfword = &flash[(Address - FEE_PAGE_BASE_ADDRESS) / 2];
+	if (*halfword != FEE_EMPTY_WORD) {
+		program_errors++;
+		return FLASH_ERROR_PG;
+	}
+	*halfword = Data;
+	return FLASH_COMPLETE;
 }
 
-void eeprom_write_word(uint16_t *addr, uint16_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p, value >> 8);
+uint16_t FLASH_ReadHalfWord(uint32_t Address) {
+	if (!flash_in_range(Address)) {
+		return FEE_EMPTY_WORD;
+	}
+	return flash[(Address - FEE_PAGE_BASE_ADDRESS) / 2];
 }
 
-void eeprom_write_dword(uint32_t *addr, uint32_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p++, value >> 8);
-	eeprom_write_byte(p++, value >> 16);
-	eeprom_write_byte(p, value >> 24);
-}
+void FLASH_Unlock(void) {}
+void FLASH_Lock(void) {}
 
-void eeprom_write_block(const void *buf, void *addr, uint32_t len) {
-	uint8_t *p = (uint8_t *)addr;
-	const uint8_t *src = (const uint8_t *)buf;
-	while (len--) {
-		eeprom_write_byte(p++, *src++);
-	}
+/* Fully erased flash without any erases counted yet, and power that stays on */
+void flash_test_reset(void) {
+	memset(flash, 0xFF, sizeof(flash));
+	memset(erase_counts, 0, sizeof(erase_counts));
+	program_errors = 0;
+	operations_left = -1;
 }
 
-void eeprom_update_byte(uint8_t *addr, uint8_t value) {
-	eeprom_write_byte(addr, value);
+/* Loses power after the given number of erase and program operations, -1 restores it */
+void flash_test_power_loss_after(int32_t operations) {
+	operations_left = operations;
 }
 
-void eeprom_update_word(uint16_t *addr, uint16_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p, value >> 8);
+uint32_t flash_test_erase_count(uint16_t page) {
+	return erase_counts[page];
 }
 
-void eeprom_update_dword(uint32_t *addr, uint32_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p++, value >> 8);
-	eeprom_write_byte(p++, value >> 16);
-	eeprom_write_byte(p, value >> 24);
+/* Number of times a halfword was programmed without being erased first */
+uint32_t flash_test_program_errors(void) {
+	return program_errors;
 }
 
-void eeprom_update_block(const void *buf, void *addr, uint32_t len) {
-	uint8_t *p = (uint8_t *)addr;
-	const uint8_t *src = (const uint8_t *)buf;
-	while (len--) {
-		eeprom_write_byte(p++, *src++);
-	}
+/* Direct access, e.g. to put data in an old format into the flash */
+void flash_test_write(uint32_t address, uint16_t data) {
+	flash[(address - FEE_PAGE_BASE_ADDRESS) / 2] = data;
 }
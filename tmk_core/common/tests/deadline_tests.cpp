@@ -0,0 +1,182 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <vector>
+
+extern "C" {
+#include "timer.h"
+#include "deadline.h"
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+namespace {
+
+std::vector<char> fired;
+
+void first_expired(void) { fired.push_back('1'); }
+void second_expired(void) { fired.push_back('2'); }
+void third_expired(void) { fired.push_back('3'); }
+
+deadline_t first = DEADLINE(first_expired);
+deadline_t second = DEADLINE(second_expired);
+deadline_t third = DEADLINE(third_expired);
+
+// Sets itself again on every call
+void repeat_expired(void);
+deadline_t repeat = DEADLINE(repeat_expired);
+void repeat_expired(void) {
+    fired.push_back('r');
+    deadline_set(&repeat, timer_read(), 0);
+}
+
+// Cancels the second deadline
+void cancelling_expired(void);
+deadline_t cancelling = DEADLINE(cancelling_expired);
+void cancelling_expired(void) {
+    fired.push_back('c');
+    deadline_cancel(&second);
+}
+
+}
+
+class Deadline : public testing::Test {
+public:
+    Deadline() {
+        set_time(1000);
+        fired.clear();
+    }
+    ~Deadline() {
+        deadline_cancel(&first);
+        deadline_cancel(&second);
+        deadline_cancel(&third);
+        deadline_cancel(&repeat);
+        deadline_cancel(&cancelling);
+    }
+};
+
+TEST_F(Deadline, NothingIsPendingAtStart) {
+    EXPECT_EQ(DEADLINE_NONE, deadline_next());
+    deadline_task();
+    EXPECT_TRUE(fired.empty());
+}
+
+TEST_F(Deadline, FiresWhenTheTimeoutHasPassed) {
+    deadline_set(&first, timer_read(), 100);
+    EXPECT_TRUE(deadline_pending(&first));
+    EXPECT_EQ(100, deadline_next());
+    advance_time(99);
+    deadline_task();
+    EXPECT_TRUE(fired.empty());
+    EXPECT_EQ(1, deadline_next());
+    advance_time(1);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'1'}, fired);
+    EXPECT_FALSE(deadline_pending(&first));
+    EXPECT_EQ(DEADLINE_NONE, deadline_next());
+}
+
+TEST_F(Deadline, FiresInExpiryOrder) {
+    deadline_set(&first, timer_read(), 300);
+    deadline_set(&second, timer_read(), 100);
+    advance_time(50);
+    // started later, but expires in between
+    deadline_set(&third, timer_read(), 100);
+    EXPECT_EQ(50, deadline_next());
+    advance_time(300);
+    deadline_task();
+    EXPECT_EQ((std::vector<char>{'2', '3', '1'}), fired);
+}
+
+TEST_F(Deadline, SettingAgainMovesTheDeadline) {
+    deadline_set(&first, timer_read(), 100);
+    advance_time(80);
+    deadline_set(&first, timer_read(), 100);
+    advance_time(80);
+    deadline_task();
+    EXPECT_TRUE(fired.empty());
+    advance_time(20);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'1'}, fired);
+}
+
+TEST_F(Deadline, CancelledDeadlineDoesntFire) {
+    deadline_set(&first, timer_read(), 100);
+    deadline_set(&second, timer_read(), 200);
+    deadline_cancel(&first);
+    deadline_cancel(&first);
+    EXPECT_EQ(200, deadline_next());
+    advance_time(200);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'2'}, fired);
+}
+
+TEST_F(Deadline, TimerWrapsAround) {
+    set_time(0xFFFF - 10);
+    deadline_set(&first, timer_read(), 100);
+    advance_time(99);
+    deadline_task();
+    EXPECT_TRUE(fired.empty());
+    advance_time(1);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'1'}, fired);
+}
+
+TEST_F(Deadline, StartCanBeAheadOfTheTimer) {
+    // key event times are rounded up to an odd number
+    deadline_set(&first, timer_read() + 1, 10);
+    EXPECT_EQ(11, deadline_next());
+    advance_time(10);
+    deadline_task();
+    EXPECT_TRUE(fired.empty());
+    advance_time(1);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'1'}, fired);
+}
+
+TEST_F(Deadline, DeadlineSetByItsCallbackFiresOnTheNextTask) {
+    deadline_set(&repeat, timer_read(), 0);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'r'}, fired);
+    deadline_task();
+    EXPECT_EQ((std::vector<char>{'r', 'r'}), fired);
+    EXPECT_EQ(0, deadline_next());
+}
+
+TEST_F(Deadline, OldDeadlineFiresAfterManyOthersWereSet) {
+    deadline_set(&first, timer_read(), 1000);
+    for (int i = 0; i < 150; i++) {
+        deadline_set(&second, timer_read(), 10000);
+    }
+    for (int t = 0; t < 5000; t++) {
+        advance_time(1);
+        deadline_task();
+    }
+    EXPECT_EQ(std::vector<char>{'1'}, fired);
+    EXPECT_FALSE(deadline_pending(&first));
+}
+
+TEST_F(Deadline, CallbackCanCancelAnotherPassedDeadline) {
+    deadline_set(&cancelling, timer_read(), 10);
+    deadline_set(&second, timer_read(), 20);
+    deadline_set(&third, timer_read(), 100);
+    advance_time(20);
+    deadline_task();
+    EXPECT_EQ(std::vector<char>{'c'}, fired);
+    EXPECT_FALSE(deadline_pending(&second));
+    EXPECT_TRUE(deadline_pending(&third));
+}
@@ -0,0 +1,215 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "eeprom.h"
+#include "common/chibios/eeprom_stm32.h"
+
+// Simulated flash, see test/eeprom.c
+void flash_test_reset(void);
+void flash_test_power_loss_after(int32_t operations);
+uint32_t flash_test_erase_count(uint16_t page);
+uint32_t flash_test_program_errors(void);
+void flash_test_write(uint32_t address, uint16_t data);
+}
+
+namespace {
+
+typedef std::vector<uint8_t> Contents;
+
+Contents read_all() {
+    Contents contents(FEE_DENSITY_BYTES);
+    eeprom_read_block(contents.data(), 0, FEE_DENSITY_BYTES);
+    return contents;
+}
+
+// Deterministic address and value for the n-th write of a sequence
+uint16_t address_for(unsigned n) { return (n * 37) % FEE_DENSITY_BYTES; }
+uint8_t value_for(unsigned n) { return (n * 11 + 1) & 0xFF; }
+
+}
+
+class EepromStm32 : public testing::Test {
+public:
+    EepromStm32() {
+        flash_test_reset();
+        EEPROM_Init();
+    }
+};
+
+TEST_F(EepromStm32, ErasedFlashReadsAsErasedEeprom) {
+    EXPECT_EQ(Contents(FEE_DENSITY_BYTES, 0xFF), read_all());
+    EXPECT_EQ(0xFF, eeprom_read_byte((uint8_t *)FEE_DENSITY_BYTES));
+}
+
+TEST_F(EepromStm32, WritesSurviveAReboot) {
+    eeprom_update_byte((uint8_t *)3, 0x42);
+    eeprom_update_word((uint16_t *)8, 0x1234);
+    eeprom_update_dword((uint32_t *)13, 0xDEADBEEF);
+    uint8_t block[] = {1, 2, 3, 4, 5};
+    eeprom_update_block(block, (void *)FEE_DENSITY_BYTES - 3, sizeof(block));
+
+    EEPROM_Init();
+    EXPECT_EQ(0x42, eeprom_read_byte((uint8_t *)3));
+    EXPECT_EQ(0x1234, eeprom_read_word((uint16_t *)8));
+    EXPECT_EQ(0xDEADBEEF, eeprom_read_dword((uint32_t *)13));
+    uint8_t read[5];
+    eeprom_read_block(read, (void *)FEE_DENSITY_BYTES - 3, sizeof(read));
+    // Only the bytes within the EEPROM were written
+    EXPECT_EQ(1, read[0]);
+    EXPECT_EQ(3, read[2]);
+    EXPECT_EQ(0xFF, read[3]);
+    EXPECT_EQ(0xFF, read[4]);
+    EXPECT_EQ(0u, flash_test_program_errors());
+}
+
+TEST_F(EepromStm32, UnchangedValuesAreNotWritten) {
+    eeprom_update_byte((uint8_t *)5, 7);
+    uint32_t erases = flash_test_erase_count(0) + flash_test_erase_count(FEE_BANK_PAGES);
+    for (unsigned i = 0; i < 10 * FEE_LOG_ENTRIES; i++) {
+        eeprom_update_byte((uint8_t *)5, 7);
+        eeprom_write_byte((uint8_t *)5, 7);
+    }
+    EXPECT_EQ(erases, flash_test_erase_count(0) + flash_test_erase_count(FEE_BANK_PAGES));
+}
+
+TEST_F(EepromStm32, WearIsSpreadOverAllPages) {
+    Contents model(FEE_DENSITY_BYTES, 0xFF);
+    const unsigned writes = 50 * FEE_LOG_ENTRIES;
+    for (unsigned n = 0; n < writes; n++) {
+        eeprom_update_byte((uint8_t *)(uintptr_t)address_for(n), value_for(n));
+        model[address_for(n)] = value_for(n);
+        if (n % 1000 == 0) {
+            EEPROM_Init();
+            ASSERT_EQ(model, read_all()) << "after write " << n;
+        }
+    }
+    EEPROM_Init();
+    EXPECT_EQ(model, read_all());
+    EXPECT_EQ(0u, flash_test_program_errors());
+
+    uint32_t least = UINT32_MAX, most = 0;
+    for (uint16_t page = 0; page < FEE_DENSITY_PAGES; page++) {
+        least = std::min(least, flash_test_erase_count(page));
+        most = std::max(most, flash_test_erase_count(page));
+    }
+    EXPECT_LE(most - least, 1u);
+    // Every page is erased about once per two full logs, not once per write
+    EXPECT_LE(most, writes / FEE_LOG_ENTRIES / 2 + 2);
+}
+
+TEST_F(EepromStm32, EraseClearsEverything) {
+    eeprom_update_byte((uint8_t *)1, 0);
+    EEPROM_Erase();
+    EXPECT_EQ(Contents(FEE_DENSITY_BYTES, 0xFF), read_all());
+    EEPROM_Init();
+    EXPECT_EQ(Contents(FEE_DENSITY_BYTES, 0xFF), read_all());
+}
+
+namespace {
+
+// The old format stored every byte in the low byte of its own halfword, at the top of the flash
+void write_old_format() {
+    for (uint16_t i = 0; i < FEE_LEGACY_DENSITY_BYTES; i++) {
+        flash_test_write(FEE_LEGACY_BASE_ADDRESS + i * 2, i % 3 ? 0x00FF & i : 0xFF00 | (i & 0xFF));
+    }
+}
+
+Contents old_format_contents() {
+    Contents contents(FEE_DENSITY_BYTES, 0xFF);
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES && i < FEE_LEGACY_DENSITY_BYTES; i++) {
+        contents[i] = i & 0xFF;
+    }
+    return contents;
+}
+
+}
+
+TEST_F(EepromStm32, OldFormatIsTakenOver) {
+    flash_test_reset();
+    write_old_format();
+    EEPROM_Init();
+    EXPECT_EQ(old_format_contents(), read_all());
+    EEPROM_Init();
+    EXPECT_EQ(0x12, eeprom_read_byte((uint8_t *)0x12));
+}
+
+TEST_F(EepromStm32, PowerLossWhileTakingOverKeepsTheOldFormat) {
+    // Erasing and programming bank 0, then erasing bank 1
+    const int32_t max_operations = FEE_BANK_PAGES + FEE_DENSITY_BYTES / 2 + 2 + FEE_BANK_PAGES;
+
+    for (int32_t operations = 0; operations <= max_operations; operations++) {
+        flash_test_reset();
+        write_old_format();
+        flash_test_power_loss_after(operations);
+        EEPROM_Init();
+        flash_test_power_loss_after(-1);
+
+        EEPROM_Init();
+        ASSERT_EQ(old_format_contents(), read_all()) << "power loss after " << operations << " operations";
+    }
+}
+
+TEST_F(EepromStm32, PowerLossKeepsEveryWriteBeforeIt) {
+    // Enough writes to fill the log and compact at least once
+    const unsigned writes = FEE_LOG_ENTRIES + 20;
+    // Every write programs two halfwords, a compaction erases and programs both banks
+    const unsigned compactions = writes / FEE_LOG_ENTRIES + 1;
+    const int32_t max_operations = 2 * writes + compactions * (FEE_DENSITY_BYTES / 2 + 2 * FEE_DENSITY_PAGES + 2);
+
+    // The possible contents: the initial data with the first n writes applied
+    std::vector<Contents> states;
+    Contents state(FEE_DENSITY_BYTES);
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        state[i] = i / 2;
+    }
+    states.push_back(state);
+    for (unsigned n = 0; n < writes; n++) {
+        state[address_for(n)] = value_for(n);
+        states.push_back(state);
+    }
+
+    for (int32_t operations = 0; operations <= max_operations; operations++) {
+        flash_test_reset();
+        EEPROM_Init();
+        // Data that is already there, which must never get lost
+        eeprom_update_block(states.front().data(), 0, FEE_DENSITY_BYTES);
+
+        flash_test_power_loss_after(operations);
+        for (unsigned n = 0; n < writes; n++) {
+            eeprom_update_byte((uint8_t *)(uintptr_t)address_for(n), value_for(n));
+        }
+        flash_test_power_loss_after(-1);
+
+        // Power comes back, the EEPROM must hold the result of some of the first writes
+        EEPROM_Init();
+        Contents after = read_all();
+        ASSERT_NE(states.end(), std::find(states.begin(), states.end(), after)) << "power loss after " << operations << " operations";
+        if (operations == max_operations) {
+            EXPECT_EQ(states.back(), after);
+        }
+
+        // And it keeps working
+        eeprom_update_byte((uint8_t *)1, 0xA5);
+        EEPROM_Init();
+        ASSERT_EQ(0xA5, eeprom_read_byte((uint8_t *)1));
+        ASSERT_EQ(0u, flash_test_program_errors()) << "power loss after " << operations << " operations";
+    }
+}
@@ -0,0 +1,33 @@
+SOURCE_LAYERS_CACHE_SRC :=\
+	$(TMK_PATH)/common/tests/source_layers_cache_tests.cpp \
+	$(TMK_PATH)/common/action_layer.c \
+	$(TMK_PATH)/common/util.c
+
+# A 100% keyboard sized matrix
+SOURCE_LAYERS_CACHE_DEFS := -DMATRIX_ROWS=6 -DMATRIX_COLS=21
+
+source_layers_cache_bitsliced_SRC := $(SOURCE_LAYERS_CACHE_SRC)
+source_layers_cache_bitsliced_DEFS := $(SOURCE_LAYERS_CACHE_DEFS)
+
+source_layers_cache_nibbles_SRC := $(SOURCE_LAYERS_CACHE_SRC)
+source_layers_cache_nibbles_DEFS := $(SOURCE_LAYERS_CACHE_DEFS) -DSOURCE_LAYERS_CACHE_NIBBLES
+
+source_layers_cache_bytes_SRC := $(SOURCE_LAYERS_CACHE_SRC)
+source_layers_cache_bytes_DEFS := $(SOURCE_LAYERS_CACHE_DEFS) -DSOURCE_LAYERS_CACHE_BYTES
+
+deadline_SRC :=\
+	$(TMK_PATH)/common/tests/deadline_tests.cpp \
+	$(TMK_PATH)/common/deadline.c \
+	$(TMK_PATH)/common/test/timer.c
+
+eeprom_stm32_SRC :=\
+	$(TMK_PATH)/common/tests/eeprom_stm32_tests.cpp \
+	$(TMK_PATH)/common/chibios/eeprom_stm32.c \
+	$(TMK_PATH)/common/test/eeprom.c
+# A small flash, so that the write log fills up quickly. The old format used
+# the top half of it, like on every MCU.
+eeprom_stm32_DEFS := -DEEPROM_EMU_TEST -DFEE_PAGE_SIZE=0x100 -DFEE_DENSITY_PAGES=4 -DFEE_DENSITY_BYTES=256
+
+# Four pages per bank like the MCUs with 2 KB pages, with room for every byte of the old format
+eeprom_stm32_8_pages_SRC := $(eeprom_stm32_SRC)
+eeprom_stm32_8_pages_DEFS := -DEEPROM_EMU_TEST -DFEE_PAGE_SIZE=0x100 -DFEE_DENSITY_PAGES=8 -DFEE_DENSITY_BYTES=512
@@ -0,0 +1,142 @@
+/* Copyright 2019 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The same tests are built once for every source layers cache layout, run
+ * `make test:source_layers_cache` to compare the benchmark numbers.
+ */
+
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+
+extern "C" {
+#include "action_layer.h"
+}
+
+#if defined(SOURCE_LAYERS_CACHE_BYTES)
+#define LAYOUT_NAME "bytes"
+#define LAYOUT_SIZE (MATRIX_ROWS * MATRIX_COLS)
+#define STORABLE_LAYERS 32
+#elif defined(SOURCE_LAYERS_CACHE_NIBBLES)
+#define LAYOUT_NAME "nibbles"
+#define LAYOUT_SIZE ((MATRIX_ROWS * MATRIX_COLS + 1) / 2)
+#define STORABLE_LAYERS 16
+#else
+#define LAYOUT_NAME "bit-sliced"
+#define LAYOUT_SIZE ((MATRIX_ROWS * MATRIX_COLS + 7) / 8 * MAX_LAYER_BITS)
+#define STORABLE_LAYERS 32
+#endif
+
+// Only the source layers cache is under test, the rest of the action code is stubbed out
+extern "C" {
+bool disable_action_cache = false;
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) { return 0; }
+action_t action_for_keycode(uint16_t keycode) { return (action_t){ .code = ACTION_NO }; }
+action_t action_for_key(uint8_t layer, keypos_t key) { return action_for_keycode(0); }
+void clear_keyboard_but_mods(void) {}
+void clear_keyboard_but_mods_and_keys(void) {}
+}
+
+namespace {
+
+keypos_t key_at(uint16_t index) {
+    return keypos_t{ .col = (uint8_t)(index % MATRIX_COLS), .row = (uint8_t)(index / MATRIX_COLS) };
+}
+
+// Deterministic, different layer for every key and round
+uint8_t layer_for(uint16_t index, unsigned round) {
+    return (index * 7 + round * 3) % STORABLE_LAYERS;
+}
+
+}
+
+class SourceLayersCache : public testing::Test {
+public:
+    SourceLayersCache() {
+        for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+            update_source_layers_cache(key_at(i), 0);
+        }
+    }
+};
+
+TEST_F(SourceLayersCache, EveryLayerCanBeStored) {
+    keypos_t key = key_at(MATRIX_COLS + 3);
+    for (uint8_t layer = 0; layer < STORABLE_LAYERS; layer++) {
+        update_source_layers_cache(key, layer);
+        EXPECT_EQ(layer, read_source_layers_cache(key));
+    }
+}
+
+TEST_F(SourceLayersCache, KeysDontAffectEachOther) {
+    for (unsigned round = 0; round < 4; round++) {
+        for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+            update_source_layers_cache(key_at(i), layer_for(i, round));
+        }
+        for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+            EXPECT_EQ(layer_for(i, round), read_source_layers_cache(key_at(i))) << "key " << i;
+        }
+    }
+}
+
+TEST_F(SourceLayersCache, HighLayerIsReleasedOnTheLayerItWasPressedOn) {
+    keypos_t key = key_at(5);
+    layer_state = (1UL << 20) | (1UL << 3);
+    uint8_t pressed_on = layer_switch_get_layer(key);
+    EXPECT_LT(pressed_on, STORABLE_LAYERS);
+    update_source_layers_cache(key, pressed_on);
+    layer_state = 0;
+    EXPECT_EQ(pressed_on, read_source_layers_cache(key));
+}
+
+TEST_F(SourceLayersCache, OnlyStorableLayersCanBeTurnedOn) {
+    layer_state_set(0);
+    layer_on(3);
+    layer_on(20);
+    EXPECT_TRUE(layer_state_is(3));
+    EXPECT_EQ(STORABLE_LAYERS > 20, layer_state_is(20));
+    default_layer_set(1UL << 20);
+    EXPECT_EQ(STORABLE_LAYERS > 20 ? 1UL << 20 : 0, default_layer_state);
+    layer_state_set(0);
+    default_layer_set(0);
+}
+
+TEST_F(SourceLayersCache, Benchmark) {
+    const unsigned rounds = 2000;
+    unsigned checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned round = 0; round < rounds; round++) {
+        for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+            // a press stores the layer, the matching release reads it back
+            update_source_layers_cache(key_at(i), layer_for(i, round));
+            checksum += read_source_layers_cache(key_at(i));
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    unsigned expected = 0;
+    for (unsigned round = 0; round < rounds; round++) {
+        for (uint16_t i = 0; i < MATRIX_ROWS * MATRIX_COLS; i++) {
+            expected += layer_for(i, round);
+        }
+    }
+    EXPECT_EQ(expected, checksum);
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * MATRIX_ROWS * MATRIX_COLS);
+    printf("\nsource layers cache %-10s %4u bytes RAM, %6.2f ns per update and read\n\n",
+        LAYOUT_NAME, (unsigned)LAYOUT_SIZE, ns);
+}
@@ -0,0 +1,7 @@
+TEST_LIST +=\
+	source_layers_cache_bitsliced\
+	source_layers_cache_nibbles\
+	source_layers_cache_bytes\
+	deadline\
+	eeprom_stm32\
+	eeprom_stm32_8_pages
@@ -49,6 +49,9 @@
 #endif
 #include "suspend.h"
 #include "wait.h"
+#ifdef MATRIX_SCAN_ON_CHANGE
+#include "matrix.h"
+#endif
 
 /* -------------------------
  *   TMK host driver defs
@@ -224,6 +227,13 @@ int main(void) {
 #endif
 #ifdef RAW_ENABLE
     raw_hid_task();
+#endif
+#ifdef MATRIX_SCAN_ON_CHANGE
+    /* Nothing to scan until a key is pressed, give the CPU to the other
+     * threads, or to the idle thread, for a tick instead of spinning */
+    if(matrix_is_idle()) {
+      chThdSleepMilliseconds(1);
+    }
 #endif
   }
 }
@@ -53,6 +53,9 @@
 #include "lufa.h"
 #include "quantum.h"
 #include <util/atomic.h>
+#ifdef MATRIX_SCAN_ON_CHANGE
+#include <avr/sleep.h>
+#endif
 #include "outputselect.h"
 #include "rgblight_reconfig.h"
 
@@ -1103,6 +1106,14 @@ int main(void)
         USB_USBTask();
 #endif
 
+#ifdef MATRIX_SCAN_ON_CHANGE
+        /* Nothing to scan until a key is pressed. Idle sleep keeps the USB and
+         * the timers running, the 1ms timer tick or a pin change wakes it up */
+        if (matrix_is_idle()) {
+            set_sleep_mode(SLEEP_MODE_IDLE);
+            sleep_mode();
+        }
+#endif
     }
 }
 